@@ -0,0 +1,288 @@
+/**
+ * @file benchdata.cc
+ * @brief Definitions for the synthetic data used by benchmarks.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#include "benchdata.h"
+
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+/* ------------------------------------------------------------------------- */
+static void generateKeys (
+        QVector<int> & out, int rows, int cardinality,
+        BenchDistribution distribution, double zipf_s, std::mt19937 & gen)
+{
+    out.resize (rows);
+    if (cardinality < 1)
+        cardinality = 1;
+
+    switch (distribution) {
+    case BenchUniform: {
+        std::uniform_int_distribution<int> dist (0, cardinality - 1);
+        for (int i = 0; i < rows; ++i) {
+            out[i] = dist (gen);
+        }
+        break; }
+    case BenchZipf: {
+        // rank k is picked with probability proportional to 1 / k^s
+        std::vector<double> cdf (cardinality);
+        double sum = 0.0;
+        for (int k = 0; k < cardinality; ++k) {
+            sum += 1.0 / std::pow (static_cast<double>(k + 1), zipf_s);
+            cdf[k] = sum;
+        }
+        std::uniform_real_distribution<double> dist (0.0, sum);
+        for (int i = 0; i < rows; ++i) {
+            std::vector<double>::const_iterator it = std::upper_bound (
+                        cdf.begin (), cdf.end (), dist (gen));
+            int k = static_cast<int>(it - cdf.begin ());
+            out[i] = qMin (k, cardinality - 1);
+        }
+        break; }
+    case BenchSorted: {
+        for (int i = 0; i < rows; ++i) {
+            out[i] = static_cast<int>(
+                        static_cast<qint64>(i) * cardinality / rows);
+        }
+        break; }
+    case BenchReverse: {
+        for (int i = 0; i < rows; ++i) {
+            out[i] = static_cast<int>(
+                        static_cast<qint64>(rows - i - 1) * cardinality / rows);
+        }
+        break; }
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The grouping keys use the requested number of groups; the sorting keys
+ * follow the same distribution over the number of rows.
+ */
+BenchData benchGenerate (const BenchSpec & spec)
+{
+    std::mt19937 gen (spec.seed_);
+    BenchData result;
+    generateKeys (result.group_keys_, spec.rows_, spec.groups_,
+                  spec.distribution_, spec.zipf_s_, gen);
+    generateKeys (result.sort_keys_, spec.rows_, spec.rows_,
+                  spec.distribution_, spec.zipf_s_, gen);
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+BenchModel::BenchModel (
+        const BenchData & data, BenchKeyType key_type, QObject * parent) :
+    QAbstractTableModel (parent),
+    data_(data),
+    key_type_(key_type),
+    decoration_()
+{
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int BenchModel::rowCount (const QModelIndex & parent) const
+{
+    return parent.isValid () ? 0 : data_.group_keys_.count ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int BenchModel::columnCount (const QModelIndex & parent) const
+{
+    return parent.isValid () ? 0 : 3;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QVariant BenchModel::keyValue (int value) const
+{
+    switch (key_type_) {
+    case BenchDouble:
+        return QVariant (value * 0.5);
+    case BenchString:
+        // zero padded so that text order matches numeric order
+        return QVariant (QString ("k%1").arg (value, 8, 10, QChar ('0')));
+    default:
+        return QVariant (value);
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QVariant BenchModel::data (const QModelIndex & index, int role) const
+{
+    if (!index.isValid ())
+        return QVariant ();
+    if (role == Qt::DecorationRole)
+        return index.column () == 2 ? decoration_ : QVariant ();
+    if ((role != Qt::DisplayRole) && (role != Qt::EditRole))
+        return QVariant ();
+
+    int row = index.row ();
+    switch (index.column ()) {
+    case 0:
+        return keyValue (data_.group_keys_.at (row));
+    case 1:
+        return keyValue (data_.sort_keys_.at (row));
+    case 2:
+        return QVariant (QString ("Item %1").arg (row));
+    default:
+        return QVariant ();
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool benchParseDistribution (const QString & name, BenchDistribution * out)
+{
+    for (int i = BenchUniform; i <= BenchReverse; ++i) {
+        if (benchDistributionName (static_cast<BenchDistribution>(i)) == name) {
+            *out = static_cast<BenchDistribution>(i);
+            return true;
+        }
+    }
+    return false;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QString benchDistributionName (BenchDistribution value)
+{
+    switch (value) {
+    case BenchUniform: return QLatin1String ("uniform");
+    case BenchZipf: return QLatin1String ("zipf");
+    case BenchSorted: return QLatin1String ("sorted");
+    case BenchReverse: return QLatin1String ("reverse");
+    }
+    return QString ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool benchParseKeyType (const QString & name, BenchKeyType * out)
+{
+    for (int i = BenchInt; i <= BenchString; ++i) {
+        if (benchKeyTypeName (static_cast<BenchKeyType>(i)) == name) {
+            *out = static_cast<BenchKeyType>(i);
+            return true;
+        }
+    }
+    return false;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QString benchKeyTypeName (BenchKeyType value)
+{
+    switch (value) {
+    case BenchInt: return QLatin1String ("int");
+    case BenchDouble: return QLatin1String ("double");
+    case BenchString: return QLatin1String ("string");
+    }
+    return QString ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @return an empty vector if any of the entries is not a positive integer
+ */
+QVector<int> benchParseSizes (const QString & text)
+{
+    QVector<int> result;
+    foreach (const QString & s, text.split (QLatin1Char (','), QString::SkipEmptyParts)) {
+        bool b_ok = false;
+        int value = s.trimmed ().toInt (&b_ok);
+        if (!b_ok || (value <= 0))
+            return QVector<int> ();
+        result.append (value);
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void benchSummarize (QVector<double> timings, double * min_ms, double * median_ms)
+{
+    if (timings.isEmpty ()) {
+        *min_ms = 0.0;
+        *median_ms = 0.0;
+        return;
+    }
+    std::sort (timings.begin (), timings.end ());
+    *min_ms = timings.first ();
+    *median_ms = timings.at (timings.count () / 2);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+BenchWriter::BenchWriter (QTextStream & stream, bool csv) :
+    stream_(stream),
+    csv_(csv),
+    header_written_(false)
+{
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void BenchWriter::write (const BenchResult & result)
+{
+    double per_second = result.min_ms_ > 0.0 ?
+                result.count_ * 1000.0 / result.min_ms_ : 0.0;
+
+    if (csv_) {
+        if (!header_written_) {
+            stream_ << "name,rows,groups,distribution,type,count,"
+                       "min_ms,median_ms,per_second,exponent,extra\n";
+            header_written_ = true;
+        }
+        stream_ << result.name_ << ','
+                << result.spec_.rows_ << ','
+                << result.spec_.groups_ << ','
+                << benchDistributionName (result.spec_.distribution_) << ','
+                << benchKeyTypeName (result.spec_.key_type_) << ','
+                << result.count_ << ','
+                << result.min_ms_ << ','
+                << result.median_ms_ << ','
+                << per_second << ',';
+        if (result.has_exponent_)
+            stream_ << result.exponent_;
+        stream_ << ',' << result.extra_.join (QLatin1Char (';')) << '\n';
+    } else {
+        stream_ << "{\"name\":\"" << result.name_ << '"'
+                << ",\"rows\":" << result.spec_.rows_
+                << ",\"groups\":" << result.spec_.groups_
+                << ",\"distribution\":\""
+                << benchDistributionName (result.spec_.distribution_) << '"'
+                << ",\"type\":\"" << benchKeyTypeName (result.spec_.key_type_) << '"'
+                << ",\"count\":" << result.count_
+                << ",\"min_ms\":" << result.min_ms_
+                << ",\"median_ms\":" << result.median_ms_
+                << ",\"per_second\":" << per_second;
+        if (result.has_exponent_)
+            stream_ << ",\"exponent\":" << result.exponent_;
+        foreach (const QString & kv, result.extra_) {
+            int sep = kv.indexOf (QLatin1Char ('='));
+            QString value = kv.mid (sep + 1);
+            bool b_num = false;
+            value.toDouble (&b_num);
+            stream_ << ",\"" << kv.left (sep) << "\":";
+            if (b_num)
+                stream_ << value;
+            else
+                stream_ << '"' << value << '"';
+        }
+        stream_ << "}\n";
+    }
+    stream_.flush ();
+}
+/* ========================================================================= */
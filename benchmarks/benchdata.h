@@ -0,0 +1,176 @@
+/**
+ * @file benchdata.h
+ * @brief Declarations for the synthetic data used by benchmarks
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#ifndef GUARD_BENCHDATA_H_INCLUDE
+#define GUARD_BENCHDATA_H_INCLUDE
+
+#include <QAbstractTableModel>
+#include <QVector>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+//! How the keys are spread across the rows.
+enum BenchDistribution {
+    BenchUniform = 0, /**< each key is equally likely */
+    BenchZipf, /**< few keys are used by most rows */
+    BenchSorted, /**< keys increase with the row */
+    BenchReverse /**< keys decrease with the row */
+};
+
+//! The type of the values in key columns.
+enum BenchKeyType {
+    BenchInt = 0,
+    BenchDouble,
+    BenchString
+};
+
+//! Parameters used to generate the data.
+class BenchSpec {
+public:
+    BenchSpec () :
+        rows_(1000),
+        groups_(100),
+        distribution_(BenchUniform),
+        key_type_(BenchInt),
+        zipf_s_(1.0),
+        seed_(1)
+    {}
+    int rows_; /**< number of rows in the model */
+    int groups_; /**< number of distinct values in grouping column */
+    BenchDistribution distribution_; /**< how the keys are spread */
+    BenchKeyType key_type_; /**< type of the keys */
+    double zipf_s_; /**< exponent for Zipf distribution */
+    unsigned seed_; /**< seed for the random generator */
+};
+
+//! Keys for all rows in the base model.
+class BenchData {
+public:
+    QVector<int> group_keys_; /**< the key for grouping column */
+    QVector<int> sort_keys_; /**< the key for sorting column */
+};
+
+//! Generate the keys described by a specification.
+BenchData
+benchGenerate (
+        const BenchSpec & spec);
+
+//! A read-only table over generated data.
+//!
+//! Column 0 is the grouping key, column 1 the sorting key and
+//! column 2 a label (and the decoration, if one was set).
+class BenchModel : public QAbstractTableModel {
+public:
+
+    BenchModel (
+            const BenchData & data,
+            BenchKeyType key_type,
+            QObject * parent = NULL);
+
+    virtual int
+    rowCount (
+            const QModelIndex & parent = QModelIndex()) const;
+
+    virtual int
+    columnCount (
+            const QModelIndex & parent = QModelIndex()) const;
+
+    virtual QVariant
+    data (
+            const QModelIndex & index,
+            int role = Qt::DisplayRole) const;
+
+    //! Set the value returned for decoration role in column 2.
+    void
+    setDecoration (
+            const QVariant & value) {
+        decoration_ = value;
+    }
+
+private:
+
+    QVariant
+    keyValue (
+            int value) const;
+
+    BenchData data_; /**< the keys (implicitly shared) */
+    BenchKeyType key_type_; /**< type of the keys */
+    QVariant decoration_; /**< same image for all rows */
+};
+
+//! Parse the name of a distribution.
+bool
+benchParseDistribution (
+        const QString & name,
+        BenchDistribution * out);
+
+//! The name of a distribution.
+QString
+benchDistributionName (
+        BenchDistribution value);
+
+//! Parse the name of a key type.
+bool
+benchParseKeyType (
+        const QString & name,
+        BenchKeyType * out);
+
+//! The name of a key type.
+QString
+benchKeyTypeName (
+        BenchKeyType value);
+
+//! Parse a comma separated list of positive integers.
+QVector<int>
+benchParseSizes (
+        const QString & text);
+
+//! One measurement.
+class BenchResult {
+public:
+    BenchResult () :
+        name_(), spec_(), count_(0), min_ms_(0.0), median_ms_(0.0),
+        exponent_(0.0), has_exponent_(false), extra_()
+    {}
+    QString name_; /**< the operation that was measured */
+    BenchSpec spec_; /**< the data that was used */
+    int count_; /**< number of units processed in one run */
+    double min_ms_; /**< fastest run */
+    double median_ms_; /**< median run */
+    double exponent_; /**< growth exponent relative to previous size */
+    bool has_exponent_; /**< exponent_ is meaningful */
+    QStringList extra_; /**< additional key=value pairs */
+};
+
+//! Writes the results as JSON lines or CSV.
+class BenchWriter {
+public:
+
+    BenchWriter (
+            QTextStream & stream,
+            bool csv);
+
+    void
+    write (
+            const BenchResult & result);
+
+private:
+    QTextStream & stream_; /**< destination */
+    bool csv_; /**< CSV instead of JSON lines */
+    bool header_written_; /**< the CSV header was written */
+};
+
+//! Minimum and median of a set of timings (in milliseconds).
+void
+benchSummarize (
+        QVector<double> timings,
+        double * min_ms,
+        double * median_ms);
+
+#endif // GUARD_BENCHDATA_H_INCLUDE
@@ -0,0 +1,350 @@
+/**
+ * @file modelbench.cc
+ * @brief Benchmarks for GroupModel and GroupSubModel.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ *
+ * Builds synthetic base models and times the operations of the model
+ * for each requested size. One line is printed for each operation and
+ * size (JSON lines by default, CSV with --csv). The exponent field
+ * estimates how the time grows relative to previous size: 1 is linear,
+ * 2 is quadratic.
+ *
+ * With --memory the operations are not timed; instead, for each size,
+ * the model is built and its item cache filled, and the estimate
+ * of GroupModel::memoryUsage() is reported in total, per row and
+ * for each part.
+ *
+ * With --access the base model is wrapped in a GroupCountingProxy, the
+ * operations run once for each size and the report of the proxy (calls
+ * by column and role, repeated fetches in each operation) is printed
+ * instead of timings.
+ */
+#include "benchdata.h"
+
+#include <grouplistwidget/groupmodel.h>
+#include <grouplistwidget/groupcountingproxy.h>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMap>
+#include <QPair>
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+/* ------------------------------------------------------------------------- */
+static double elapsedMs (const QElapsedTimer & timer)
+{
+    return timer.nsecsElapsed () / 1.0e6;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+//! Timings for all operations on one data set, in the order they run.
+class SuiteTimings {
+public:
+    void add (const QString & name, int count, double ms) {
+        if (!timings_.contains (name)) {
+            order_.append (name);
+            counts_.insert (name, count);
+        }
+        timings_[name].append (ms);
+    }
+    QStringList order_;
+    QMap<QString, int> counts_;
+    QMap<QString, QVector<double> > timings_;
+    QMap<QString, QStringList> extra_;
+};
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+static SuiteTimings runSuite (
+        const BenchSpec & spec, int repeat, int lookups)
+{
+    SuiteTimings result;
+    BenchData data = benchGenerate (spec);
+
+    std::mt19937 gen (spec.seed_ + 1);
+    std::uniform_int_distribution<int> row_dist (0, spec.rows_ - 1);
+    QVector<int> probe (lookups);
+    for (int i = 0; i < lookups; ++i) {
+        probe[i] = row_dist (gen);
+    }
+
+    QElapsedTimer timer;
+    for (int r = 0; r < repeat; ++r) {
+        GroupModel gm;
+
+        // the model takes ownership of the base model
+        timer.start ();
+        gm.setBaseModel (new BenchModel (data, spec.key_type_));
+        result.add ("setBaseModel", spec.rows_, elapsedMs (timer));
+
+        timer.start ();
+        gm.setGroupingColumn (0);
+        result.add ("setGroupingColumn", spec.rows_, elapsedMs (timer));
+
+        timer.start ();
+        gm.setSortingColumn (1);
+        result.add ("setSortingColumn", spec.rows_, elapsedMs (timer));
+
+        timer.start ();
+        gm.setSortingDirection (Qt::DescendingOrder);
+        result.add ("setSortingDirection", spec.rows_, elapsedMs (timer));
+
+        timer.start ();
+        gm.removeSorting ();
+        result.add ("removeSorting", spec.rows_, elapsedMs (timer));
+
+        timer.start ();
+        gm.regroup ();
+        result.add ("regroup", spec.rows_, elapsedMs (timer));
+
+        // first lookup pays for the reverse index
+        gm.invalidateRowIndex ();
+        timer.start ();
+        gm.groupForRow (0);
+        result.add ("groupForRow.index", spec.rows_, elapsedMs (timer));
+
+        qint64 checksum = 0;
+        timer.start ();
+        for (int i = 0; i < lookups; ++i) {
+            int in_group = 0;
+            if (gm.groupForRow (probe.at (i), &in_group) != NULL)
+                checksum += in_group;
+        }
+        result.add ("groupForRow", lookups, elapsedMs (timer));
+
+        result.extra_["setGroupingColumn"] = QStringList ()
+                << QString ("group_count=%1").arg (gm.groupCount ());
+        result.extra_["groupForRow"] = QStringList ()
+                << QString ("checksum=%1").arg (checksum);
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+//! Memory used by a model grouped and sorted on the synthetic data.
+static BenchResult measureMemory (const BenchSpec & spec)
+{
+    BenchData data = benchGenerate (spec);
+    GroupModel gm;
+    gm.setBaseModel (new BenchModel (data, spec.key_type_), 0, 1);
+    int i_max = qMin (spec.rows_, gm.itemCacheSize ());
+    for (int i = 0; i < i_max; ++i) {
+        gm.itemData (i);
+    }
+    gm.groupForRow (0);
+
+    GroupMemoryUsage usage = gm.memoryUsage ();
+    BenchResult result;
+    result.name_ = QLatin1String ("memory");
+    result.spec_ = spec;
+    result.count_ = spec.rows_;
+    result.extra_ << QString ("bytes=%1").arg (usage.totalBytes ())
+                  << QString ("bytes_per_row=%1").arg (
+                         spec.rows_ > 0 ?
+                             double (usage.totalBytes ()) / spec.rows_ : 0.0);
+    for (int i = 0; i < GroupMemoryUsage::PartCount; ++i) {
+        GroupMemoryUsage::Part part = GroupMemoryUsage::Part (i);
+        if (usage.count (part) == 0)
+            continue;
+        result.extra_ << QString ("%1_bytes=%2")
+                         .arg (GroupMemoryUsage::partName (part))
+                         .arg (usage.bytes (part));
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+//! The calls that each operation makes to the base model.
+static QString countAccess (const BenchSpec & spec)
+{
+    BenchData data = benchGenerate (spec);
+    GroupCountingProxy * proxy = new GroupCountingProxy ();
+    BenchModel * bm = new BenchModel (data, spec.key_type_);
+    bm->setParent (proxy);
+    proxy->setSourceModel (bm);
+
+    // the model takes ownership of the proxy
+    GroupModel gm;
+    proxy->beginOperation ("setBaseModel");
+    gm.setBaseModel (proxy);
+    proxy->endOperation ();
+    proxy->followModel (&gm);
+    gm.setGroupingColumn (0);
+    gm.setSortingColumn (1);
+    gm.setSortingDirection (Qt::DescendingOrder);
+    gm.removeSorting ();
+    gm.regroup ();
+
+    proxy->beginOperation ("itemData");
+    int i_max = qMin (spec.rows_, gm.itemCacheSize ());
+    for (int i = 0; i < i_max; ++i) {
+        gm.itemData (i);
+    }
+    proxy->endOperation ();
+    proxy->followModel (NULL);
+
+    return QString ("%1 rows, %2 distribution\n%3\n")
+            .arg (spec.rows_)
+            .arg (benchDistributionName (spec.distribution_))
+            .arg (proxy->report ());
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int main (int argc, char *argv[])
+{
+    QCoreApplication app (argc, argv);
+    QCoreApplication::setApplicationName ("grouplistwidget-modelbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription (
+                "Times GroupModel operations on synthetic data.");
+    parser.addHelpOption ();
+    QCommandLineOption opt_sizes ("sizes",
+                "Comma separated row counts.", "list",
+                "1000,10000,100000,1000000");
+    QCommandLineOption opt_groups ("groups",
+                "Number of distinct grouping keys.", "count", "100");
+    QCommandLineOption opt_dist ("distribution",
+                "uniform, zipf, sorted, reverse or all.", "name", "all");
+    QCommandLineOption opt_type ("type",
+                "Type of the keys: int, double or string.", "name", "int");
+    QCommandLineOption opt_zipf ("zipf-s",
+                "Exponent of the Zipf distribution.", "value", "1.0");
+    QCommandLineOption opt_repeat ("repeat",
+                "Runs for each measurement.", "count", "3");
+    QCommandLineOption opt_lookups ("lookups",
+                "Number of groupForRow() calls.", "count", "100000");
+    QCommandLineOption opt_seed ("seed",
+                "Seed for the random generator.", "value", "1");
+    QCommandLineOption opt_limit ("time-limit",
+                "Skip larger sizes once an operation takes longer (ms).",
+                "ms", "30000");
+    QCommandLineOption opt_memory ("memory",
+                "Report the memory used instead of timings.");
+    QCommandLineOption opt_access ("access",
+                "Report the calls made to base model instead of timings.");
+    QCommandLineOption opt_csv ("csv", "Write CSV instead of JSON lines.");
+    QCommandLineOption opt_output ("output",
+                "Write the results to a file.", "path");
+    parser.addOption (opt_sizes);
+    parser.addOption (opt_groups);
+    parser.addOption (opt_dist);
+    parser.addOption (opt_type);
+    parser.addOption (opt_zipf);
+    parser.addOption (opt_repeat);
+    parser.addOption (opt_lookups);
+    parser.addOption (opt_seed);
+    parser.addOption (opt_limit);
+    parser.addOption (opt_memory);
+    parser.addOption (opt_access);
+    parser.addOption (opt_csv);
+    parser.addOption (opt_output);
+    parser.process (app);
+
+    QVector<int> sizes = benchParseSizes (parser.value (opt_sizes));
+    if (sizes.isEmpty ()) {
+        fprintf (stderr, "Invalid list of sizes\n");
+        return 1;
+    }
+
+    QList<BenchDistribution> distributions;
+    if (parser.value (opt_dist) == QLatin1String ("all")) {
+        distributions << BenchUniform << BenchZipf << BenchSorted << BenchReverse;
+    } else {
+        BenchDistribution d;
+        if (!benchParseDistribution (parser.value (opt_dist), &d)) {
+            fprintf (stderr, "Unknown distribution\n");
+            return 1;
+        }
+        distributions << d;
+    }
+
+    BenchSpec spec;
+    if (!benchParseKeyType (parser.value (opt_type), &spec.key_type_)) {
+        fprintf (stderr, "Unknown key type\n");
+        return 1;
+    }
+    spec.groups_ = qMax (1, parser.value (opt_groups).toInt ());
+    spec.zipf_s_ = parser.value (opt_zipf).toDouble ();
+    spec.seed_ = parser.value (opt_seed).toUInt ();
+    int repeat = qMax (1, parser.value (opt_repeat).toInt ());
+    int lookups = qMax (1, parser.value (opt_lookups).toInt ());
+    double limit_ms = parser.value (opt_limit).toDouble ();
+
+    QFile file;
+    if (parser.isSet (opt_output)) {
+        file.setFileName (parser.value (opt_output));
+        if (!file.open (QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            fprintf (stderr, "Cannot open %s\n", qPrintable (file.fileName ()));
+            return 1;
+        }
+    } else {
+        file.open (stdout, QIODevice::WriteOnly | QIODevice::Text);
+    }
+    QTextStream stream (&file);
+    BenchWriter writer (stream, parser.isSet (opt_csv));
+
+    foreach (BenchDistribution d, distributions) {
+        spec.distribution_ = d;
+        // previous size and fastest time for each operation
+        QMap<QString, QPair<int, double> > previous;
+        foreach (int rows, sizes) {
+            spec.rows_ = rows;
+            if (parser.isSet (opt_memory)) {
+                writer.write (measureMemory (spec));
+                continue;
+            } else if (parser.isSet (opt_access)) {
+                stream << countAccess (spec);
+                continue;
+            }
+            SuiteTimings suite = runSuite (spec, repeat, lookups);
+
+            bool b_too_slow = false;
+            foreach (const QString & name, suite.order_) {
+                BenchResult res;
+                res.name_ = name;
+                res.spec_ = spec;
+                res.count_ = suite.counts_.value (name);
+                res.extra_ = suite.extra_.value (name);
+                benchSummarize (suite.timings_.value (name),
+                                &res.min_ms_, &res.median_ms_);
+
+                // lookups are counted per call, not per row
+                if (previous.contains (name) && (name != QLatin1String ("groupForRow"))) {
+                    QPair<int, double> prev = previous.value (name);
+                    if ((prev.second > 0.0) && (res.min_ms_ > 0.0) && (prev.first != rows)) {
+                        res.exponent_ =
+                                std::log (res.min_ms_ / prev.second) /
+                                std::log (static_cast<double>(rows) / prev.first);
+                        res.has_exponent_ = true;
+                    }
+                }
+                previous.insert (name, qMakePair (rows, res.min_ms_));
+                writer.write (res);
+
+                if ((limit_ms > 0.0) && (res.min_ms_ > limit_ms))
+                    b_too_slow = true;
+            }
+            if (b_too_slow) {
+                fprintf (stderr, "Skipping sizes above %d for %s\n",
+                         rows, qPrintable (benchDistributionName (d)));
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+/* ========================================================================= */
@@ -0,0 +1,122 @@
+/**
+ * @file replay.cc
+ * @brief Replays a recording made with GroupRecorder.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ *
+ * Applies the records to a fresh GroupModel, either alone or inside a
+ * GroupListWidget that runs with the offscreen platform (unless
+ * QT_QPA_PLATFORM says otherwise), and prints the latency percentiles
+ * for each kind of record. In widget mode the posted events are
+ * processed after each record, so the latencies include the work
+ * done by the widget.
+ */
+#include <grouplistwidget/grouplistwidget.h>
+#include <grouplistwidget/grouplistdelegate.h>
+#include <grouplistwidget/groupmodel.h>
+#include <grouplistwidget/groupreplayer.h>
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QFile>
+
+#include <cstdio>
+
+/* ------------------------------------------------------------------------- */
+//! Let the widget handle posted events (layouts, lazy lists, timers at 0).
+static void settle ()
+{
+    QCoreApplication::sendPostedEvents ();
+    QCoreApplication::processEvents ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int main (int argc, char *argv[])
+{
+    if (qgetenv ("QT_QPA_PLATFORM").isEmpty ())
+        qputenv ("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app (argc, argv);
+    QApplication::setApplicationName ("grouplistwidget-replay");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription (
+                "Replays a GroupRecorder file and reports the latencies.");
+    parser.addHelpOption ();
+    parser.addPositionalArgument ("file", "The recording.");
+    QCommandLineOption opt_realtime ("realtime",
+                "Follow the times in the recording.");
+    QCommandLineOption opt_widget ("widget",
+                "Show the model in a GroupListWidget.");
+    QCommandLineOption opt_delegate ("delegate",
+                "Use GroupListDelegate in the widget.");
+    QCommandLineOption opt_width ("width", "Width of the widget.", "px", "1024");
+    QCommandLineOption opt_height ("height", "Height of the widget.", "px", "768");
+    QCommandLineOption opt_output ("output",
+                "Write the report to a file.", "path");
+    parser.addOption (opt_realtime);
+    parser.addOption (opt_widget);
+    parser.addOption (opt_delegate);
+    parser.addOption (opt_width);
+    parser.addOption (opt_height);
+    parser.addOption (opt_output);
+    parser.process (app);
+
+    if (parser.positionalArguments ().count () != 1) {
+        parser.showHelp (1);
+    }
+
+    GroupReplayer replayer;
+    if (!replayer.load (parser.positionalArguments ().at (0))) {
+        fprintf (stderr, "%s\n", qPrintable (replayer.errorString ()));
+        return 1;
+    }
+
+    GroupListWidget * w = NULL;
+    GroupModel * model = NULL;
+    if (parser.isSet (opt_widget)) {
+        w = new GroupListWidget ();
+        w->resize (qMax (64, parser.value (opt_width).toInt ()),
+                   qMax (64, parser.value (opt_height).toInt ()));
+        if (parser.isSet (opt_delegate))
+            w->setListDelegate (new GroupListDelegate ());
+        w->show ();
+        settle ();
+        model = w->underModel ();
+        QObject::connect (&replayer, &GroupReplayer::recordApplied, settle);
+    } else {
+        model = new GroupModel ();
+    }
+
+    bool b_ret = replayer.run (model, parser.isSet (opt_realtime));
+    if (!b_ret) {
+        fprintf (stderr, "%s\n", qPrintable (replayer.errorString ()));
+    } else {
+        QString report = QString ("%1 records, %2 ms recorded\n%3")
+                .arg (replayer.recordCount ())
+                .arg (replayer.duration () / 1.0e6, 0, 'f', 1)
+                .arg (replayer.report ());
+        if (parser.isSet (opt_output)) {
+            QFile f (parser.value (opt_output));
+            if (!f.open (QIODevice::WriteOnly | QIODevice::Truncate)) {
+                fprintf (stderr, "Cannot write to %s\n",
+                         qPrintable (parser.value (opt_output)));
+                b_ret = false;
+            } else {
+                f.write (report.toUtf8 ());
+            }
+        } else {
+            fputs (qPrintable (report), stdout);
+        }
+    }
+
+    if (w != NULL)
+        delete w;
+    else
+        delete model;
+    return b_ret ? 0 : 1;
+}
+/* ========================================================================= */
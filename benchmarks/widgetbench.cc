@@ -0,0 +1,307 @@
+/**
+ * @file widgetbench.cc
+ * @brief Headless benchmarks for GroupListWidget.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ *
+ * Runs with the offscreen platform (unless QT_QPA_PLATFORM says otherwise)
+ * and times building the widget for a number of groups, resizing it,
+ * zooming with setPixmapSize(), switching the view mode and rendering
+ * the widget into a QImage. Each operation is measured with and without
+ * GroupListDelegate. The output uses the same format as
+ * grouplistwidget-modelbench; per_second counts visible items and
+ * ms_per_item divides the time of one operation by the number of
+ * items that are visible after it.
+ */
+#include "benchdata.h"
+
+#include <grouplistwidget/grouplistwidget.h>
+#include <grouplistwidget/grouplistdelegate.h>
+#include <grouplistwidget/groupmodel.h>
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QLinearGradient>
+#include <QListView>
+#include <QMap>
+#include <QPainter>
+#include <QPixmap>
+
+#include <cstdio>
+
+/* ------------------------------------------------------------------------- */
+static double elapsedMs (const QElapsedTimer & timer)
+{
+    return timer.nsecsElapsed () / 1.0e6;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+//! Let the widget handle posted events (layouts, lazy lists, timers at 0).
+static void settle ()
+{
+    QCoreApplication::sendPostedEvents ();
+    QCoreApplication::processEvents ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+//! Number of items whose rectangle intersects the viewport of the widget.
+static int visibleItems (GroupListWidget * w)
+{
+    int result = 0;
+    QRect vp = w->viewport ()->rect ();
+    foreach (QListView * lv, w->findChildren<QListView*> ()) {
+        if (!lv->isVisible () || (lv->model () == NULL))
+            continue;
+        QRect lv_rect (lv->mapTo (w->viewport (), QPoint (0, 0)), lv->size ());
+        QRect shown = lv_rect.intersected (vp);
+        if (shown.isEmpty ())
+            continue;
+        shown.translate (-lv_rect.topLeft ());
+        int i_max = lv->model ()->rowCount ();
+        for (int i = 0; i < i_max; ++i) {
+            QRect r = lv->visualRect (lv->model ()->index (i, 0));
+            r.translate (lv->viewport ()->pos ());
+            if (r.intersects (shown))
+                ++result;
+        }
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+//! Paint the widget and its lists into an image.
+static void renderWidget (GroupListWidget * w, QImage & img)
+{
+    img.fill (Qt::white);
+    QPainter painter (&img);
+    w->render (&painter);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+//! Timings for all operations on one data set, in the order they run.
+class SuiteTimings {
+public:
+    void add (const QString & name, int steps, int visible, double ms) {
+        if (!timings_.contains (name))
+            order_.append (name);
+        timings_[name].append (ms / steps);
+        visible_[name] = visible;
+    }
+    QStringList order_;
+    QMap<QString, QVector<double> > timings_;
+    QMap<QString, int> visible_;
+};
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+static SuiteTimings runSuite (
+        const BenchSpec & spec, int repeat, bool use_delegate,
+        bool lazy, const QSize & size, const QVariant & decoration,
+        int * group_count)
+{
+    SuiteTimings result;
+    BenchData data = benchGenerate (spec);
+    QImage img (size, QImage::Format_ARGB32_Premultiplied);
+
+    QElapsedTimer timer;
+    for (int r = 0; r < repeat; ++r) {
+        GroupListWidget w;
+        w.resize (size);
+        w.setLazyViews (lazy);
+        w.setPixmapSize (64);
+        if (use_delegate)
+            w.setListDelegate (new GroupListDelegate ());
+        w.show ();
+        settle ();
+
+        BenchModel * bm = new BenchModel (data, spec.key_type_);
+        bm->setDecoration (decoration);
+        w.underModel ()->setPixmapColumn (2);
+
+        timer.start ();
+        w.underModel ()->setBaseModel (bm, 0, -1);
+        settle ();
+        result.add ("build", 1, visibleItems (&w), elapsedMs (timer));
+        *group_count = w.underModel ()->groupCount ();
+
+        // one warm up so that the first paint does not carry one-time costs
+        renderWidget (&w, img);
+        timer.start ();
+        renderWidget (&w, img);
+        result.add ("render", 1, visibleItems (&w), elapsedMs (timer));
+
+        const int resize_steps = 4;
+        timer.start ();
+        for (int i = 0; i < resize_steps; ++i) {
+            w.resize (i % 2 == 0 ?
+                          QSize (size.width () * 3 / 2, size.height ()) :
+                          size);
+            settle ();
+        }
+        result.add ("resize", resize_steps, visibleItems (&w), elapsedMs (timer));
+
+        static const int zoom[] = { 32, 48, 96, 128, 96, 64 };
+        const int zoom_steps = sizeof(zoom) / sizeof(zoom[0]);
+        timer.start ();
+        for (int i = 0; i < zoom_steps; ++i) {
+            w.setPixmapSize (zoom[i]);
+            settle ();
+        }
+        result.add ("setPixmapSize", zoom_steps, visibleItems (&w), elapsedMs (timer));
+
+        timer.start ();
+        w.setViewMode (QListView::ListMode);
+        settle ();
+        w.setViewMode (QListView::IconMode);
+        settle ();
+        result.add ("setViewMode", 2, visibleItems (&w), elapsedMs (timer));
+
+        renderWidget (&w, img);
+        timer.start ();
+        renderWidget (&w, img);
+        result.add ("render.after", 1, visibleItems (&w), elapsedMs (timer));
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int main (int argc, char *argv[])
+{
+    if (qgetenv ("QT_QPA_PLATFORM").isEmpty ())
+        qputenv ("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app (argc, argv);
+    QApplication::setApplicationName ("grouplistwidget-widgetbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription (
+                "Times GroupListWidget operations without a display.");
+    parser.addHelpOption ();
+    QCommandLineOption opt_groups ("groups",
+                "Comma separated group counts.", "list", "10,100,1000");
+    QCommandLineOption opt_per_group ("per-group",
+                "Average number of items in a group.", "count", "50");
+    QCommandLineOption opt_dist ("distribution",
+                "uniform, zipf, sorted or reverse.", "name", "uniform");
+    QCommandLineOption opt_delegate ("delegate",
+                "on, off or both.", "mode", "both");
+    QCommandLineOption opt_lazy ("lazy", "Create the lists lazily.");
+    QCommandLineOption opt_width ("width", "Width of the widget.", "px", "1024");
+    QCommandLineOption opt_height ("height", "Height of the widget.", "px", "768");
+    QCommandLineOption opt_repeat ("repeat",
+                "Runs for each measurement.", "count", "3");
+    QCommandLineOption opt_seed ("seed",
+                "Seed for the random generator.", "value", "1");
+    QCommandLineOption opt_csv ("csv", "Write CSV instead of JSON lines.");
+    QCommandLineOption opt_output ("output",
+                "Write the results to a file.", "path");
+    parser.addOption (opt_groups);
+    parser.addOption (opt_per_group);
+    parser.addOption (opt_dist);
+    parser.addOption (opt_delegate);
+    parser.addOption (opt_lazy);
+    parser.addOption (opt_width);
+    parser.addOption (opt_height);
+    parser.addOption (opt_repeat);
+    parser.addOption (opt_seed);
+    parser.addOption (opt_csv);
+    parser.addOption (opt_output);
+    parser.process (app);
+
+    QVector<int> group_counts = benchParseSizes (parser.value (opt_groups));
+    if (group_counts.isEmpty ()) {
+        fprintf (stderr, "Invalid list of group counts\n");
+        return 1;
+    }
+
+    BenchSpec spec;
+    if (!benchParseDistribution (parser.value (opt_dist), &spec.distribution_)) {
+        fprintf (stderr, "Unknown distribution\n");
+        return 1;
+    }
+    spec.seed_ = parser.value (opt_seed).toUInt ();
+    int per_group = qMax (1, parser.value (opt_per_group).toInt ());
+    int repeat = qMax (1, parser.value (opt_repeat).toInt ());
+    bool lazy = parser.isSet (opt_lazy);
+    QSize size (qMax (64, parser.value (opt_width).toInt ()),
+                qMax (64, parser.value (opt_height).toInt ()));
+
+    QList<bool> delegate_modes;
+    QString delegate_mode = parser.value (opt_delegate);
+    if (delegate_mode == QLatin1String ("on")) {
+        delegate_modes << true;
+    } else if (delegate_mode == QLatin1String ("off")) {
+        delegate_modes << false;
+    } else if (delegate_mode == QLatin1String ("both")) {
+        delegate_modes << false << true;
+    } else {
+        fprintf (stderr, "Unknown delegate mode\n");
+        return 1;
+    }
+
+    // all rows share one large image so that scaling is part of the cost
+    QPixmap pix (256, 256);
+    {
+        QPainter painter (&pix);
+        QLinearGradient grad (0, 0, 256, 256);
+        grad.setColorAt (0.0, Qt::darkBlue);
+        grad.setColorAt (1.0, Qt::yellow);
+        painter.fillRect (pix.rect (), grad);
+    }
+    QVariant decoration = QVariant::fromValue (pix);
+
+    QFile file;
+    if (parser.isSet (opt_output)) {
+        file.setFileName (parser.value (opt_output));
+        if (!file.open (QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            fprintf (stderr, "Cannot open %s\n", qPrintable (file.fileName ()));
+            return 1;
+        }
+    } else {
+        file.open (stdout, QIODevice::WriteOnly | QIODevice::Text);
+    }
+    QTextStream stream (&file);
+    BenchWriter writer (stream, parser.isSet (opt_csv));
+
+    foreach (bool use_delegate, delegate_modes) {
+        foreach (int groups, group_counts) {
+            spec.groups_ = groups;
+            spec.rows_ = groups * per_group;
+
+            int group_count = 0;
+            SuiteTimings suite = runSuite (
+                        spec, repeat, use_delegate, lazy, size,
+                        decoration, &group_count);
+
+            foreach (const QString & name, suite.order_) {
+                BenchResult res;
+                res.name_ = name;
+                res.spec_ = spec;
+                res.count_ = suite.visible_.value (name);
+                benchSummarize (suite.timings_.value (name),
+                                &res.min_ms_, &res.median_ms_);
+                double per_item = res.count_ > 0 ? res.min_ms_ / res.count_ : 0.0;
+                res.extra_
+                        << QString ("delegate=%1").arg (use_delegate ? "on" : "off")
+                        << QString ("lazy=%1").arg (lazy ? "on" : "off")
+                        << QString ("group_count=%1").arg (group_count)
+                        << QString ("visible_items=%1").arg (res.count_)
+                        << QString ("ms_per_item=%1").arg (per_item);
+                writer.write (res);
+            }
+        }
+    }
+
+    return 0;
+}
+/* ========================================================================= */
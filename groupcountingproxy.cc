@@ -0,0 +1,245 @@
+/**
+ * @file groupcountingproxy.cc
+ * @brief Definitions for GroupCountingProxy class.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#include "groupcountingproxy.h"
+#include "groupmodel.h"
+
+#include <QStringList>
+#include <algorithm>
+
+/**
+ * @class GroupCountingProxy
+ *
+ * The proxy forwards everything to its source model and counts the
+ * calls to index(), data() and headerData(). The totals are kept by
+ * column (or section) and role for the lifetime of the proxy.
+ *
+ * Between beginOperation() and endOperation() the proxy also remembers
+ * each (row, column, role) that was fetched, so fetching the same value
+ * twice in one operation shows up as a repeated fetch. With
+ * followModel() the counting never stops: each operation reported by
+ * GroupModel::operationPerformed() ends the group of calls in progress
+ * and, unless that group was named by beginOperation(), gives it its name.
+ * Work that is not a GroupModel operation (installing the model,
+ * scrolling, painting) can be separated with beginOperation().
+ *
+ * Cells are identified by 32 bits of row, 16 bits of column and 16 bits
+ * of role. The proxy is not thread safe; all calls are expected to come
+ * from the thread that owns it.
+ */
+
+/* ------------------------------------------------------------------------- */
+GroupCountingProxy::GroupCountingProxy (QObject * parent) :
+    QIdentityProxyModel (parent),
+    data_calls_(),
+    index_calls_(),
+    header_calls_(),
+    cells_(),
+    current_(),
+    counting_cells_(false),
+    operations_(),
+    followed_()
+{
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupCountingProxy::~GroupCountingProxy ()
+{
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupCountingProxy::beginOperation (const QString & name)
+{
+    endOperation ();
+    current_ = Operation ();
+    current_.name_ = name;
+    counting_cells_ = true;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Operations that made no calls are not remembered.
+ */
+void GroupCountingProxy::endOperation ()
+{
+    if (!counting_cells_)
+        return;
+    counting_cells_ = false;
+
+    current_.distinct_cells_ = cells_.count ();
+    QHash<CellKey, qint64>::const_iterator it = cells_.constBegin ();
+    QHash<CellKey, qint64>::const_iterator it_end = cells_.constEnd ();
+    CellKey worst;
+    for (; it != it_end; ++it) {
+        if (it.value () > current_.worst_count_) {
+            current_.worst_count_ = it.value ();
+            worst = it.key ();
+        }
+    }
+    if (current_.worst_count_ > 0) {
+        current_.worst_row_ = worst.first.first;
+        current_.worst_column_ = worst.first.second;
+        current_.worst_role_ = worst.second;
+    }
+    cells_.clear ();
+
+    if (current_.name_.isEmpty ())
+        current_.name_ = QLatin1String ("(other)");
+    if ((current_.index_calls_ > 0) || (current_.data_calls_ > 0) ||
+            (current_.header_calls_ > 0)) {
+        operations_.append (current_);
+    }
+    current_ = Operation ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupCountingProxy::followModel (GroupModel * model)
+{
+    if (!followed_.isNull ())
+        disconnect (followed_.data (), NULL, this, NULL);
+    followed_ = model;
+    if (model != NULL) {
+        connect (model, &GroupModel::operationPerformed,
+                 this, &GroupCountingProxy::modelOperation);
+        if (!counting_cells_)
+            beginOperation (QString ());
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupCountingProxy::modelOperation (int operation, int /*value*/)
+{
+    if (current_.name_.isEmpty ())
+        current_.name_ = GroupModel::operationName (operation);
+    beginOperation (QString ());
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupCountingProxy::clear ()
+{
+    data_calls_.clear ();
+    index_calls_.clear ();
+    header_calls_.clear ();
+    cells_.clear ();
+    operations_.clear ();
+    QString name = current_.name_;
+    current_ = Operation ();
+    current_.name_ = name;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QModelIndex GroupCountingProxy::index (
+        int row, int column, const QModelIndex & parent) const
+{
+    ++index_calls_[column];
+    ++current_.index_calls_;
+    return QIdentityProxyModel::index (row, column, parent);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QVariant GroupCountingProxy::data (const QModelIndex & index, int role) const
+{
+    ++data_calls_[qMakePair (index.column (), role)];
+    ++current_.data_calls_;
+    if (counting_cells_)
+        ++cells_[cellKey (index.row (), index.column (), role)];
+    return QIdentityProxyModel::data (index, role);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QVariant GroupCountingProxy::headerData (
+        int section, Qt::Orientation orientation, int role) const
+{
+    ++header_calls_[qMakePair (section, role)];
+    ++current_.header_calls_;
+    return QIdentityProxyModel::headerData (section, orientation, role);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QString GroupCountingProxy::roleName (int role) const
+{
+    QByteArray name = roleNames ().value (role);
+    if (name.isEmpty ())
+        return QString::number (role);
+    return QString::fromLatin1 (name);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The operation in progress is not included.
+ */
+QString GroupCountingProxy::report () const
+{
+    QString result;
+
+    // data() by column and role, most used first
+    QList<QPair<qint64, QPair<int, int> > > by_count;
+    QHash<QPair<int, int>, qint64>::const_iterator it = data_calls_.constBegin ();
+    for (; it != data_calls_.constEnd (); ++it) {
+        by_count.append (qMakePair (it.value (), it.key ()));
+    }
+    std::sort (by_count.begin (), by_count.end ());
+    std::reverse (by_count.begin (), by_count.end ());
+
+    result.append (QString ("%1 %2 %3 %4\n")
+                   .arg ("column", 8).arg ("role", -16)
+                   .arg ("data()", 12).arg ("index()", 12));
+    for (int i = 0; i < by_count.count (); ++i) {
+        int column = by_count.at (i).second.first;
+        int role = by_count.at (i).second.second;
+        result.append (QString ("%1 %2 %3 %4\n")
+                       .arg (column, 8).arg (roleName (role), -16)
+                       .arg (by_count.at (i).first, 12)
+                       .arg (index_calls_.value (column), 12));
+    }
+
+    qint64 headers = 0;
+    foreach (qint64 n, header_calls_) {
+        headers += n;
+    }
+    if (headers > 0)
+        result.append (QString ("headerData(): %1 calls\n").arg (headers));
+
+    if (!operations_.isEmpty ()) {
+        result.append (QString ("\n%1 %2 %3 %4 %5  %6\n")
+                       .arg ("operation", -20).arg ("data()", 10)
+                       .arg ("distinct", 10).arg ("repeated", 10)
+                       .arg ("index()", 10).arg ("most fetched cell"));
+        foreach (const Operation & op, operations_) {
+            QString worst;
+            if (op.worst_count_ > 1) {
+                worst = QString ("(%1, %2, %3) x%4")
+                        .arg (op.worst_row_).arg (op.worst_column_)
+                        .arg (roleName (op.worst_role_))
+                        .arg (op.worst_count_);
+            }
+            result.append (QString ("%1 %2 %3 %4 %5  %6\n")
+                           .arg (op.name_, -20)
+                           .arg (op.data_calls_, 10)
+                           .arg (op.distinct_cells_, 10)
+                           .arg (op.repeatedFetches (), 10)
+                           .arg (op.index_calls_, 10)
+                           .arg (worst));
+        }
+    }
+    return result;
+}
+/* ========================================================================= */
+
+void GroupCountingProxy::anchorVtable () const {}
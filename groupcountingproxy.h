@@ -0,0 +1,167 @@
+/**
+ * @file groupcountingproxy.h
+ * @brief Declarations for GroupCountingProxy class
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#ifndef GUARD_GROUPCOUNTINGPROXY_H_INCLUDE
+#define GUARD_GROUPCOUNTINGPROXY_H_INCLUDE
+
+#include <grouplistwidget/grouplistwidget-config.h>
+#include <QIdentityProxyModel>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QPointer>
+#include <QString>
+
+class GroupModel;
+
+//! Counts the calls made to a model (install it as the base model of a GroupModel).
+class GROUPLISTWIDGET_EXPORT GroupCountingProxy : public QIdentityProxyModel {
+    Q_OBJECT
+
+public:
+
+    //! The calls made between beginOperation() and endOperation().
+    class Operation {
+    public:
+        Operation () :
+            name_(), index_calls_(0), data_calls_(0), header_calls_(0),
+            distinct_cells_(0), worst_row_(-1), worst_column_(-1),
+            worst_role_(-1), worst_count_(0)
+        {}
+
+        //! Calls to data() for a cell that was already fetched.
+        qint64
+        repeatedFetches () const {
+            return data_calls_ - distinct_cells_;
+        }
+
+        QString name_; /**< the name of the operation */
+        qint64 index_calls_; /**< calls to index() */
+        qint64 data_calls_; /**< calls to data() */
+        qint64 header_calls_; /**< calls to headerData() */
+        qint64 distinct_cells_; /**< distinct (row, column, role) fetched */
+        int worst_row_; /**< row of the cell fetched most often */
+        int worst_column_; /**< column of the cell fetched most often */
+        int worst_role_; /**< role of the cell fetched most often */
+        qint64 worst_count_; /**< number of fetches of that cell */
+    };
+
+    //! Default constructor.
+    explicit GroupCountingProxy (
+            QObject * parent = NULL);
+
+    //! Destructor.
+    virtual ~GroupCountingProxy ();
+
+    //! Start counting the fetches for an operation (ends the current one).
+    void
+    beginOperation (
+            const QString & name);
+
+    //! Stop counting the fetches for current operation.
+    void
+    endOperation ();
+
+    //! Name each group of calls after the GroupModel operation that ends it.
+    void
+    followModel (
+            GroupModel * model);
+
+    //! The operations that ended, in order.
+    const QList<Operation> &
+    operations () const {
+        return operations_;
+    }
+
+    //! Calls to data() for a column and a role.
+    qint64
+    dataCalls (
+            int column,
+            int role) const {
+        return data_calls_.value (qMakePair (column, role));
+    }
+
+    //! Calls to index() for a column.
+    qint64
+    indexCalls (
+            int column) const {
+        return index_calls_.value (column);
+    }
+
+    //! Calls to headerData() for a section and a role.
+    qint64
+    headerCalls (
+            int section,
+            int role) const {
+        return header_calls_.value (qMakePair (section, role));
+    }
+
+    //! Forget all counts and operations.
+    void
+    clear ();
+
+    //! A table with the counts by column and role and one line for each operation.
+    QString
+    report () const;
+
+    virtual QModelIndex
+    index (
+            int row,
+            int column,
+            const QModelIndex & parent = QModelIndex()) const;
+
+    virtual QVariant
+    data (
+            const QModelIndex & index,
+            int role = Qt::DisplayRole) const;
+
+    virtual QVariant
+    headerData (
+            int section,
+            Qt::Orientation orientation,
+            int role = Qt::DisplayRole) const;
+
+private slots:
+
+    void
+    modelOperation (
+            int operation,
+            int value);
+
+private:
+
+    //! Identifies a cell and a role: ((row, column), role).
+    typedef QPair<QPair<int, int>, int> CellKey;
+
+    //! The key for a cell in the fetches of an operation.
+    static CellKey
+    cellKey (
+            int row,
+            int column,
+            int role) {
+        return qMakePair (qMakePair (row, column), role);
+    }
+
+    //! A readable name for a role.
+    QString
+    roleName (
+            int role) const;
+
+    mutable QHash<QPair<int, int>, qint64> data_calls_; /**< data() by column and role */
+    mutable QHash<int, qint64> index_calls_; /**< index() by column */
+    mutable QHash<QPair<int, int>, qint64> header_calls_; /**< headerData() by section and role */
+    mutable QHash<CellKey, qint64> cells_; /**< fetches of each cell in current operation */
+    mutable Operation current_; /**< the operation in progress */
+    bool counting_cells_; /**< an operation is in progress */
+    QList<Operation> operations_; /**< operations that ended */
+    QPointer<GroupModel> followed_; /**< the model whose operations name the counts */
+
+public: virtual void anchorVtable() const;
+}; // class GroupCountingProxy
+
+#endif // GUARD_GROUPCOUNTINGPROXY_H_INCLUDE
@@ -0,0 +1,136 @@
+/**
+ * @file groupframestats.cc
+ * @brief Definitions for GroupFrameStats class.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#include "groupframestats.h"
+
+/**
+ * @class GroupFrameStats
+ *
+ * A frame is the work done by a GroupListWidget between two
+ * iterations of the event loop: the paint events of the tree and of the
+ * lists and the calls that arrange the lists. The counters of the caches
+ * are the changes seen during the frame; GroupGeometryCache is shared,
+ * so its counters also include the requests of other widgets.
+ */
+
+/* ------------------------------------------------------------------------- */
+GroupFrameStats::GroupFrameStats ()
+{
+    clear ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupFrameStats::clear ()
+{
+    for (int i = 0; i < CounterCount; ++i) {
+        counters_[i] = 0;
+    }
+    paint_ns_ = 0;
+    arrange_ns_ = 0;
+    frame_ = 0;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool GroupFrameStats::isEmpty () const
+{
+    if ((paint_ns_ != 0) || (arrange_ns_ != 0))
+        return false;
+    for (int i = 0; i < CounterCount; ++i) {
+        if (counters_[i] != 0)
+            return false;
+    }
+    return true;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+double GroupFrameStats::hitRate (Counter hits, Counter misses) const
+{
+    qint64 total = counters_[hits] + counters_[misses];
+    if (total <= 0)
+        return -1.0;
+    return 100.0 * counters_[hits] / total;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+const char * GroupFrameStats::counterName (Counter counter)
+{
+    switch (counter) {
+    case CounterPaintEvents: return "paint_events";
+    case CounterListsPainted: return "lists_painted";
+    case CounterItemsPainted: return "items_painted";
+    case CounterHeadersPainted: return "headers_painted";
+    case CounterHeaderHits: return "header_hits";
+    case CounterHeaderMisses: return "header_misses";
+    case CounterTileHits: return "tile_hits";
+    case CounterTileMisses: return "tile_misses";
+    case CounterTextHits: return "text_hits";
+    case CounterTextMisses: return "text_misses";
+    case CounterPixmapHits: return "pixmap_hits";
+    case CounterPixmapMisses: return "pixmap_misses";
+    case CounterGeometryHits: return "geometry_hits";
+    case CounterGeometryMisses: return "geometry_misses";
+    case CounterArrangeCalls: return "arrange_calls";
+    default: return "";
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Caches that were not used in this frame are left out.
+ */
+QString GroupFrameStats::toString () const
+{
+    QString result = QString ("frame %1: paint %2 ms in %3 events\n")
+            .arg (frame_)
+            .arg (paint_ns_ / 1000000.0, 0, 'f', 2)
+            .arg (counters_[CounterPaintEvents]);
+    result.append (QString ("items %1 in %2 lists, headers %3\n")
+                   .arg (counters_[CounterItemsPainted])
+                   .arg (counters_[CounterListsPainted])
+                   .arg (counters_[CounterHeadersPainted]));
+    if (counters_[CounterArrangeCalls] > 0) {
+        result.append (QString ("arrange %1 ms in %2 calls\n")
+                       .arg (arrange_ns_ / 1000000.0, 0, 'f', 2)
+                       .arg (counters_[CounterArrangeCalls]));
+    }
+
+    static const struct {
+        const char * name;
+        Counter hits;
+        Counter misses;
+    } caches[] = {
+        { "headers", CounterHeaderHits, CounterHeaderMisses },
+        { "tiles", CounterTileHits, CounterTileMisses },
+        { "text", CounterTextHits, CounterTextMisses },
+        { "pixmaps", CounterPixmapHits, CounterPixmapMisses },
+        { "geometry", CounterGeometryHits, CounterGeometryMisses }
+    };
+    QString rates;
+    for (unsigned i = 0; i < sizeof (caches) / sizeof (caches[0]); ++i) {
+        double rate = hitRate (caches[i].hits, caches[i].misses);
+        if (rate < 0.0)
+            continue;
+        if (!rates.isEmpty ())
+            rates.append (", ");
+        rates.append (QString ("%1 %2%")
+                      .arg (caches[i].name)
+                      .arg (rate, 0, 'f', 0));
+    }
+    if (!rates.isEmpty ()) {
+        result.append ("hits: ");
+        result.append (rates);
+        result.append ("\n");
+    }
+    return result;
+}
+/* ========================================================================= */
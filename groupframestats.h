@@ -0,0 +1,129 @@
+/**
+ * @file groupframestats.h
+ * @brief Declarations for GroupFrameStats class
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#ifndef GUARD_GROUPFRAMESTATS_H_INCLUDE
+#define GUARD_GROUPFRAMESTATS_H_INCLUDE
+
+#include <grouplistwidget/grouplistwidget-config.h>
+#include <QString>
+#include <QMetaType>
+
+//! The cost of painting one frame of a GroupListWidget.
+class GROUPLISTWIDGET_EXPORT GroupFrameStats {
+
+public:
+
+    //! The events that are counted.
+    enum Counter {
+        CounterPaintEvents = 0, /**< paint events handled by the tree and the lists */
+        CounterListsPainted, /**< paint events handled by the lists */
+        CounterItemsPainted, /**< items painted by the lists */
+        CounterHeadersPainted, /**< group headers painted by the tree */
+        CounterHeaderHits, /**< headers served from QPixmapCache */
+        CounterHeaderMisses, /**< headers that had to be rendered */
+        CounterTileHits, /**< tiles served from QPixmapCache */
+        CounterTileMisses, /**< tiles that had to be rendered */
+        CounterTextHits, /**< labels served from the text cache of the delegate */
+        CounterTextMisses, /**< labels that had to be laid out */
+        CounterPixmapHits, /**< images served from existing pyramid levels */
+        CounterPixmapMisses, /**< images that needed new pyramid levels */
+        CounterGeometryHits, /**< geometry served from GroupGeometryCache */
+        CounterGeometryMisses, /**< geometry that had to be computed */
+        CounterArrangeCalls, /**< calls to GroupListWidget::arangeLists() */
+        CounterCount
+    };
+
+    //! Default constructor.
+    GroupFrameStats ();
+
+    //! Forget all values.
+    void
+    clear ();
+
+    //! Is this an empty frame?
+    bool
+    isEmpty () const;
+
+    //! Count some events.
+    void
+    add (
+            Counter counter,
+            qint64 value = 1) {
+        counters_[counter] += value;
+    }
+
+    //! The number of events.
+    qint64
+    value (
+            Counter counter) const {
+        return counters_[counter];
+    }
+
+    //! Account time spent painting.
+    void
+    addPaintNs (
+            qint64 value) {
+        paint_ns_ += value;
+    }
+
+    //! Time spent in paint events, in nanoseconds.
+    qint64
+    paintNs () const {
+        return paint_ns_;
+    }
+
+    //! Account time spent arranging the lists.
+    void
+    addArrangeNs (
+            qint64 value) {
+        arrange_ns_ += value;
+    }
+
+    //! Time spent in GroupListWidget::arangeLists(), in nanoseconds.
+    qint64
+    arrangeNs () const {
+        return arrange_ns_;
+    }
+
+    //! The sequence number of the frame in its widget.
+    int
+    frame () const {
+        return frame_;
+    }
+
+    //! Change the sequence number of the frame.
+    void
+    setFrame (
+            int value) {
+        frame_ = value;
+    }
+
+    //! Percent of requests served from a cache (-1 if there were none).
+    double
+    hitRate (
+            Counter hits,
+            Counter misses) const;
+
+    //! Name of a counter.
+    static const char *
+    counterName (
+            Counter counter);
+
+    //! A few lines that summarize the frame.
+    QString
+    toString () const;
+
+private:
+    qint64 counters_[CounterCount]; /**< the value of each counter */
+    qint64 paint_ns_; /**< time spent in paint events */
+    qint64 arrange_ns_; /**< time spent arranging the lists */
+    int frame_; /**< sequence number */
+};
+Q_DECLARE_METATYPE(GroupFrameStats)
+
+#endif // GUARD_GROUPFRAMESTATS_H_INCLUDE
@@ -0,0 +1,145 @@
+/**
+ * @file groupgeometrycache.cc
+ * @brief Definitions for GroupGeometryCache class.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#include "groupgeometrycache.h"
+#include "groupmemoryusage.h"
+#include "grouplistwidget-private.h"
+#include <QFontMetrics>
+
+/**
+ * @class GroupGeometryCache
+ *
+ * Building a QFontMetrics and asking it for sizes is not free and the
+ * same values are needed each time the view is reset, zoomed or changes
+ * its mode. This class keeps the metrics by font and the geometry of
+ * an item by font, pixmap size, view mode, label count and device
+ * pixel ratio.
+ *
+ * All widgets use the global() instance unless told otherwise, so
+ * widgets that look the same share the values. The class is meant to be
+ * used from the GUI thread.
+ */
+
+/* ------------------------------------------------------------------------- */
+GroupGeometryCache::GroupGeometryCache (int capacity) :
+    fonts_(capacity),
+    items_(capacity),
+    hits_(0),
+    misses_(0)
+{
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupGeometryCache::~GroupGeometryCache ()
+{
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupGeometryCache * GroupGeometryCache::global ()
+{
+    static GroupGeometryCache instance;
+    return &instance;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupFontGeometry GroupGeometryCache::fontGeometry (
+        const QFont & font, int dpr)
+{
+    QString key = font.key () + QLatin1Char ('|') + QString::number (dpr);
+    GroupFontGeometry * cached = fonts_.object (key);
+    if (cached != NULL) {
+        ++hits_;
+        return *cached;
+    }
+    ++misses_;
+
+    QFontMetrics fm (font);
+    GroupFontGeometry result;
+    result.avg_char_width_ = fm.averageCharWidth ();
+    result.height_ = fm.height ();
+    fonts_.insert (key, new GroupFontGeometry (result));
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @return true if the geometry was found and copied to \b out
+ */
+bool GroupGeometryCache::itemGeometry (
+        const QFont & font, int pixmap_size, int view_mode,
+        int label_count, int dpr, GroupItemGeometry * out)
+{
+    GroupItemGeometry * cached = items_.object (
+                itemKey (font, pixmap_size, view_mode, label_count, dpr));
+    if (cached == NULL) {
+        ++misses_;
+        return false;
+    }
+    ++hits_;
+    if (out != NULL)
+        *out = *cached;
+    return true;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupGeometryCache::setItemGeometry (
+        const QFont & font, int pixmap_size, int view_mode,
+        int label_count, int dpr, const GroupItemGeometry & value)
+{
+    items_.insert (
+                itemKey (font, pixmap_size, view_mode, label_count, dpr),
+                new GroupItemGeometry (value));
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupGeometryCache::clear ()
+{
+    fonts_.clear ();
+    items_.clear ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupGeometryCache::addMemoryUsage (GroupMemoryUsage * usage) const
+{
+    foreach (const QString & key, fonts_.keys ()) {
+        usage->add (GroupMemoryUsage::PartGeometry,
+                    GroupMemoryUsage::cacheNodeBytes () +
+                    GroupMemoryUsage::stringBytes (key) +
+                    sizeof (GroupFontGeometry));
+    }
+    foreach (const QString & key, items_.keys ()) {
+        usage->add (GroupMemoryUsage::PartGeometry,
+                    GroupMemoryUsage::cacheNodeBytes () +
+                    GroupMemoryUsage::stringBytes (key) +
+                    sizeof (GroupItemGeometry));
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QString GroupGeometryCache::itemKey (
+        const QFont & font, int pixmap_size, int view_mode,
+        int label_count, int dpr)
+{
+    return QString ("%1|%2|%3|%4|%5")
+            .arg (font.key ())
+            .arg (pixmap_size)
+            .arg (view_mode)
+            .arg (label_count)
+            .arg (dpr);
+}
+/* ========================================================================= */
+
+void GroupGeometryCache::anchorVtable () const {}
@@ -0,0 +1,120 @@
+/**
+ * @file groupgeometrycache.h
+ * @brief Declarations for GroupGeometryCache class
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#ifndef GUARD_GROUPGEOMETRYCACHE_H_INCLUDE
+#define GUARD_GROUPGEOMETRYCACHE_H_INCLUDE
+
+#include <grouplistwidget/grouplistwidget-config.h>
+#include <QCache>
+#include <QString>
+#include <QFont>
+#include <QSize>
+#include <QRect>
+
+class GroupMemoryUsage;
+
+//! Text metrics for a font.
+class GroupFontGeometry {
+public:
+    GroupFontGeometry () : avg_char_width_(0), height_(0) {}
+    int avg_char_width_; /**< average width of a character */
+    int height_; /**< height of a line of text */
+};
+
+//! The place of the elements inside an item in the lists.
+class GroupItemGeometry {
+public:
+    GroupItemGeometry () : item_size_(), pix_pos_(), text_pos_() {}
+    QSize item_size_; /**< size of an item */
+    QRect pix_pos_; /**< where the image is painted */
+    QRect text_pos_; /**< where the first label is painted */
+};
+
+//! Remembers font metrics and item geometry so they are computed once.
+class GROUPLISTWIDGET_EXPORT GroupGeometryCache {
+
+public:
+
+    //! Default constructor.
+    explicit GroupGeometryCache (
+            int capacity = 64);
+
+    //! Destructor.
+    virtual ~GroupGeometryCache ();
+
+    //! The instance shared by all widgets that do not set their own.
+    static GroupGeometryCache *
+    global ();
+
+    //! Text metrics for a font.
+    GroupFontGeometry
+    fontGeometry (
+            const QFont & font,
+            int dpr);
+
+    //! Retrieve the geometry of an item, if known.
+    bool
+    itemGeometry (
+            const QFont & font,
+            int pixmap_size,
+            int view_mode,
+            int label_count,
+            int dpr,
+            GroupItemGeometry * out);
+
+    //! Remember the geometry of an item.
+    void
+    setItemGeometry (
+            const QFont & font,
+            int pixmap_size,
+            int view_mode,
+            int label_count,
+            int dpr,
+            const GroupItemGeometry & value);
+
+    //! Forget everything.
+    void
+    clear ();
+
+    //! Account the cached metrics and geometry.
+    void
+    addMemoryUsage (
+            GroupMemoryUsage * usage) const;
+
+    //! Number of requests served from the cache.
+    int
+    hits () const {
+        return hits_;
+    }
+
+    //! Number of requests that were not served from the cache.
+    int
+    misses () const {
+        return misses_;
+    }
+
+private:
+
+    //! The key for the geometry of an item.
+    static QString
+    itemKey (
+            const QFont & font,
+            int pixmap_size,
+            int view_mode,
+            int label_count,
+            int dpr);
+
+    QCache<QString, GroupFontGeometry> fonts_; /**< metrics by font */
+    QCache<QString, GroupItemGeometry> items_; /**< item geometry by all inputs */
+    int hits_; /**< requests served from the cache */
+    int misses_; /**< requests that were not served from the cache */
+
+public: virtual void anchorVtable() const;
+}; // class GroupGeometryCache
+
+#endif // GUARD_GROUPGEOMETRYCACHE_H_INCLUDE
@@ -12,6 +12,8 @@
 #include "grouplistwidget.h"
 #include "grouplistwidget-private.h"
 #include "grouplistgroup.h"
+#include "groupgeometrycache.h"
+#include "grouptracer.h"
 
 #include <QIcon>
 #include <QPixmap>
@@ -20,6 +22,7 @@
 #include <QModelIndex>
 #include <QRect>
 #include <QSize>
+#include <QTransform>
 
 /**
  * @class GroupListDelegate
@@ -38,7 +41,15 @@ GroupListDelegate::GroupListDelegate (QObject * parent) :
     pix_pos_(),
     text_pos_(),
     layout_(LayInvalid),
-    lay_count_(0)
+    lay_count_(0),
+    pyramid_(),
+    font_main_(),
+    font_other_(),
+    labels_(),
+    base_(),
+    text_cache_(2048),
+    text_hits_(0),
+    text_misses_(0)
 {
 }
 /* ========================================================================= */
@@ -48,6 +59,7 @@ void GroupListDelegate::reinit (
         GroupListWidget *lwidget, GroupModel *umodel)
 {
     GROUPLISTWIDGET_TRACE_ENTRY;
+    int old_text_width = text_pos_.width();
     for (;;) {
 
         // For now the mapping is 1:1, but - in the future, we could add more
@@ -63,16 +75,59 @@ void GroupListDelegate::reinit (
 
         // retrieve additional information from data holders
         int pix_size = lwidget->pixmapSize();
-        pix_pos_ = QRect(0, 0, pix_size, pix_size);
+        lay_count_ = umodel->labelCount();
 
-        QFontMetrics fm (lwidget->font());
-        text_pos_ = QRect(
-                    0,
-                    0,
-                    fm.averageCharWidth() * 32,
-                    static_cast<int> (fm.height() * 1.2 + 1));
+        // the geometry only depends on these inputs so other widgets
+        // (or this one, before a reset or zoom) may have computed it
+        GroupGeometryCache * gcache = lwidget->geometryCache ();
+        int dpr = lwidget->devicePixelRatio ();
+        GroupItemGeometry geom;
+        bool b_known = gcache->itemGeometry (
+                    lwidget->font(), pix_size, lwidget->viewMode (),
+                    lay_count_, dpr, &geom);
+        if (b_known) {
+            item_size_ = geom.item_size_;
+            pix_pos_ = geom.pix_pos_;
+            text_pos_ = geom.text_pos_;
+        } else {
+            pix_pos_ = QRect(0, 0, pix_size, pix_size);
+
+            GroupFontGeometry fg = gcache->fontGeometry (lwidget->font(), dpr);
+            text_pos_ = QRect(
+                        0,
+                        0,
+                        fg.avg_char_width_ * 32,
+                        static_cast<int> (fg.height_ * 1.2 + 1));
+        }
 
-        lay_count_ = umodel->labelCount();
+        // fonts are prepared once; labels laid out for other fonts,
+        // widths or columns are no longer valid
+        QFont fnt_main = lwidget->font();
+        fnt_main.setBold (true);
+        QFont fnt_other = lwidget->font();
+        fnt_other.setBold (false);
+        QList<ModelId> lbls;
+        for (int i = 0; i < lay_count_; ++i) {
+            lbls.append (umodel->label (i));
+        }
+        bool b_same_labels = (lbls.count() == labels_.count());
+        for (int i = 0; b_same_labels && (i < lay_count_); ++i) {
+            b_same_labels =
+                    (lbls.at (i).column() == labels_.at (i).column()) &&
+                    (lbls.at (i).role() == labels_.at (i).role());
+        }
+        if (!b_same_labels ||
+                (fnt_main != font_main_) ||
+                (fnt_other != font_other_) ||
+                (old_text_width != text_pos_.width())) {
+            text_cache_.clear ();
+        }
+        font_main_ = fnt_main;
+        font_other_ = fnt_other;
+        labels_ = lbls;
+        setBaseModel (umodel->baseModel());
+        if (b_known)
+            break;
 
         // total height of the labels
         int tot_label_h = lay_count_ * text_pos_.height();
@@ -116,19 +171,33 @@ void GroupListDelegate::reinit (
             item_size_ = QSize (16, 16);
         }
 
+        geom.item_size_ = item_size_;
+        geom.pix_pos_ = pix_pos_;
+        geom.text_pos_ = text_pos_;
+        gcache->setItemGeometry (
+                    lwidget->font(), pix_size, lwidget->viewMode (),
+                    lay_count_, dpr, geom);
         break;
     }
 
-    GROUPLISTWIDGET_DEBUGV("Reinitialized geometry to %d, %d\n",
-                           item_size_.width (), item_size_.height ());
-    GROUPLISTWIDGET_DEBUGV("- image pos (%d, %d), size (%d, %d)\n",
-                           pix_pos_.x (), pix_pos_.y(),
-                           pix_pos_.width (), pix_pos_.height ());
-    GROUPLISTWIDGET_DEBUGV("- text pos (%d, %d), size (%d, %d)\n",
-                           text_pos_.x (), text_pos_.y(),
-                           text_pos_.width (), text_pos_.height ());
-    GROUPLISTWIDGET_DEBUGV("- layout: %d, labels: %d\n",
-                           layout_, lay_count_);
+    GROUPLISTWIDGET_LOG_DEBUG(
+                grpLogDelegate,
+                "Reinitialized geometry to %d, %d",
+                item_size_.width (), item_size_.height ());
+    GROUPLISTWIDGET_LOG_DEBUG(
+                grpLogDelegate,
+                "- image pos (%d, %d), size (%d, %d)",
+                pix_pos_.x (), pix_pos_.y(), pix_pos_.width (),
+                pix_pos_.height ());
+    GROUPLISTWIDGET_LOG_DEBUG(
+                grpLogDelegate,
+                "- text pos (%d, %d), size (%d, %d)",
+                text_pos_.x (), text_pos_.y(), text_pos_.width (),
+                text_pos_.height ());
+    GROUPLISTWIDGET_LOG_DEBUG(
+                grpLogDelegate,
+                "- layout: %d, labels: %d",
+                layout_, lay_count_);
 
     GROUPLISTWIDGET_TRACE_EXIT;
 }
@@ -139,6 +208,7 @@ void GroupListDelegate::paint (
         QPainter * painter, const QStyleOptionViewItem & option,
         const QModelIndex & index ) const
 {
+    GROUPLISTWIDGET_TRACE_SCOPE("GroupListDelegate::paint");
     GROUPLISTWIDGET_TRACE_ENTRY;
     bool selected =
             (option.state & QStyle::State_Selected) == QStyle::State_Selected;
@@ -157,13 +227,33 @@ void GroupListDelegate::paint (
     painter->setPen (Qt::NoPen);
 #endif
     painter->drawRect (option.rect);
-    GROUPLISTWIDGET_DEBUGV("Drawing at pos (%d, %d), size (%d, %d)\n",
-                           option.rect.x (), option.rect.y(),
-                           option.rect.width (), option.rect.height ());
+    GROUPLISTWIDGET_LOG_DEBUG(
+                grpLogDelegate,
+                "Drawing at pos (%d, %d), size (%d, %d)",
+                option.rect.x (), option.rect.y(), option.rect.width (),
+                option.rect.height ());
+
+    // all the values for this item are retrieved in a single call
+    GroupItemData idata;
+    const GroupSubModel * gsm =
+            qobject_cast<const GroupSubModel *>(index.model());
+    if (gsm != NULL) {
+        idata = gsm->rowData (index.row());
+    } else {
+        idata.pixmap_ = index.data (Qt::DecorationRole);
+        for (int i = 0; i < lay_count_; ++i) {
+            idata.labels_.append (index.data (GroupModel::BaseColRole + i));
+        }
+    }
 
     QRect pix_rect = pix_pos_.translated (option.rect.topLeft());
     QRect drect;
-    QVariant vdeco = index.data(Qt::DecorationRole);
+    const QVariant & vdeco = idata.pixmap_;
+    // images are drawn from the level of the pyramid that is closest
+    // to the final size, so smooth scaling is cheap
+    qreal dpr = painter->device()->devicePixelRatioF();
+    bool b_smooth = painter->testRenderHint (QPainter::SmoothPixmapTransform);
+    painter->setRenderHint (QPainter::SmoothPixmapTransform);
 
 #   define PIX_BMP(arg) ((arg == QVariant::Pixmap) || \
                          (arg == QVariant::Bitmap))
@@ -181,6 +271,7 @@ void GroupListDelegate::paint (
                     pix_rect.x() + (pix_rect.width()  - dst_width)  / 2,
                     pix_rect.y() + (pix_rect.height() - dst_height) / 2,
                     dst_width, dst_height);
+        icon = pyramid_.level (icon, drect.size() * dpr);
         painter->drawPixmap (drect, icon);
     } else if (vdeco.type() == QVariant::Image) {
         QImage icon = qvariant_cast<QImage>(vdeco);
@@ -195,18 +286,21 @@ void GroupListDelegate::paint (
                     pix_rect.x() + (pix_rect.width()  - dst_width)  / 2,
                     pix_rect.y() + (pix_rect.height() - dst_height) / 2,
                     dst_width, dst_height);
-
+        icon = pyramid_.level (icon, drect.size() * dpr);
         painter->drawImage (drect, icon);
     } else if (vdeco.type() == QVariant::Icon) {
         QIcon icon = qvariant_cast<QIcon>(vdeco);
         icon.paint (painter, pix_rect, Qt::AlignHCenter | Qt::AlignVCenter);
     }
+    // the painter is shared with the items painted after this one
+    painter->setRenderHint (QPainter::SmoothPixmapTransform, b_smooth);
     //if (!option.icon.isNull()) {
     //    option.icon.paint (painter, option.rect, option.decorationAlignment);
     //}
-    GROUPLISTWIDGET_DEBUGV("- image pos (%d, %d), size (%d, %d)\n",
-                           drect.x (), drect.y(),
-                           drect.width (), drect.height ());
+    GROUPLISTWIDGET_LOG_DEBUG(
+                grpLogDelegate,
+                "- image pos (%d, %d), size (%d, %d)",
+                drect.x (), drect.y(), drect.width (), drect.height ());
 
     if (selected) {
         painter->setPen (option.palette.color (QPalette::HighlightedText));
@@ -216,28 +310,31 @@ void GroupListDelegate::paint (
     // painter->drawText (option.rect, option.displayAlignment, option.text);
 
     QRect text_rect = text_pos_.translated (option.rect.topLeft());
-    GROUPLISTWIDGET_DEBUGV("- first text pos (%d, %d), size (%d, %d)\n",
-                           text_rect.x (), text_rect.y(),
-                           text_rect.width (), text_rect.height ());
+    GROUPLISTWIDGET_LOG_DEBUG(
+                grpLogDelegate,
+                "- first text pos (%d, %d), size (%d, %d)",
+                text_rect.x (), text_rect.y(), text_rect.width (),
+                text_rect.height ());
+
+    // labels are laid out once per row in base model and reused
+    int key = idata.base_row_;
+    QVector<QStaticText> labels;
+    QVector<QStaticText> * cached =
+            (key == -1) ? NULL : text_cache_.object (key);
+    if ((cached != NULL) && (cached->count() == lay_count_)) {
+        labels = *cached;
+        ++text_hits_;
+    } else {
+        labels = createLabels (idata.labels_);
+        ++text_misses_;
+        if (key != -1)
+            text_cache_.insert (key, new QVector<QStaticText> (labels));
+    }
 
-    int i_max = lay_count_;
+    int i_max = labels.count();
     for (int i = 0; i < i_max; ++i) {
-        if (i == 0) {
-            QFont fp = painter->font();
-            fp.setBold (true);
-            painter->setFont (fp);
-        } else if (i == 1) {
-            QFont fp = painter->font();
-            fp.setBold (false);
-            painter->setFont (fp);
-        }
-
-        QString s_label = index.data (GroupModel::BaseColRole + i).toString();
-        painter->drawText (
-                    text_rect,
-                    Qt::AlignTop|Qt::AlignLeft,
-                    s_label);
-
+        painter->setFont (i == 0 ? font_main_ : font_other_);
+        painter->drawStaticText (text_rect.topLeft(), labels.at (i));
         text_rect.translate (0, text_rect.height());
     }
     GROUPLISTWIDGET_TRACE_EXIT;
@@ -253,4 +350,127 @@ QSize GroupListDelegate::sizeHint (
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+/**
+ * Labels are elided to fit the width of the text area and are prepared
+ * for the font that is used to paint them.
+ */
+QVector<QStaticText> GroupListDelegate::createLabels (
+        const QVariantList & values) const
+{
+    QVector<QStaticText> result;
+    result.reserve (lay_count_);
+    QFontMetrics fm_main (font_main_);
+    QFontMetrics fm_other (font_other_);
+    int text_width = text_pos_.width();
+    for (int i = 0; i < lay_count_; ++i) {
+        QString s_label = values.value (i).toString();
+        const QFontMetrics & fm = (i == 0 ? fm_main : fm_other);
+        QStaticText st (fm.elidedText (s_label, Qt::ElideRight, text_width));
+        st.setTextFormat (Qt::PlainText);
+        st.prepare (QTransform (), i == 0 ? font_main_ : font_other_);
+        result.append (st);
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListDelegate::clearTextCache ()
+{
+    text_cache_.clear ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Only the text of the labels is accounted; the glyphs Qt caches
+ * for QStaticText are not visible from here.
+ */
+void GroupListDelegate::addMemoryUsage (GroupMemoryUsage * usage) const
+{
+    foreach (int key, text_cache_.keys ()) {
+        const QVector<QStaticText> * labels = text_cache_.object (key);
+        qint64 bytes = GroupMemoryUsage::cacheNodeBytes () +
+                GroupMemoryUsage::vectorBytes (
+                    labels->capacity (), sizeof (QStaticText));
+        foreach (const QStaticText & st, *labels) {
+            bytes += GroupMemoryUsage::stringBytes (st.text ());
+        }
+        usage->add (GroupMemoryUsage::PartTextCache, bytes);
+    }
+    usage->add (GroupMemoryUsage::PartPixmapLevels,
+                qint64 (pyramid_.usedKb ()) * 1024,
+                pyramid_.sourceCount ());
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Structural changes in base model invalidate all cached labels as they are
+ * keyed by the row in base model.
+ */
+void GroupListDelegate::setBaseModel (QAbstractItemModel * model)
+{
+    if (base_ == model)
+        return;
+    if (!base_.isNull()) {
+        disconnect (base_.data(), NULL, this, NULL);
+    }
+    base_ = model;
+    text_cache_.clear ();
+
+    if (model != NULL) {
+        connect (model, &QAbstractItemModel::dataChanged,
+                 this, &GroupListDelegate::baseModelDataChange);
+        connect (model, &QAbstractItemModel::rowsInserted,
+                 this, &GroupListDelegate::clearTextCache);
+        connect (model, &QAbstractItemModel::rowsRemoved,
+                 this, &GroupListDelegate::clearTextCache);
+        connect (model, &QAbstractItemModel::rowsMoved,
+                 this, &GroupListDelegate::clearTextCache);
+        connect (model, &QAbstractItemModel::layoutChanged,
+                 this, &GroupListDelegate::clearTextCache);
+        connect (model, &QAbstractItemModel::modelReset,
+                 this, &GroupListDelegate::clearTextCache);
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Only changes in the columns and roles used by the labels are considered.
+ */
+void GroupListDelegate::baseModelDataChange (
+        const QModelIndex &topLeft, const QModelIndex &bottomRight,
+        const QVector<int> &roles)
+{
+    bool b_affected = false;
+    foreach (const ModelId & mid, labels_) {
+        if ((mid.column() < topLeft.column()) ||
+                (mid.column() > bottomRight.column()))
+            continue;
+        if (!roles.isEmpty() && !roles.contains (mid.role()))
+            continue;
+        b_affected = true;
+        break;
+    }
+    if (!b_affected)
+        return;
+
+    int first = qMin (topLeft.row(), bottomRight.row());
+    int last = qMax (topLeft.row(), bottomRight.row());
+    if (last - first > text_cache_.count()) {
+        foreach (int key, text_cache_.keys()) {
+            if ((key >= first) && (key <= last))
+                text_cache_.remove (key);
+        }
+    } else {
+        for (int i = first; i <= last; ++i) {
+            text_cache_.remove (i);
+        }
+    }
+}
+/* ========================================================================= */
+
 void GroupListDelegate::anchorVtable () const {}
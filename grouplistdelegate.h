@@ -14,9 +14,15 @@
 #include <QObject>
 #include <QAbstractItemDelegate>
 #include <QStyledItemDelegate>
+#include <QCache>
+#include <QVector>
+#include <QStaticText>
+#include <QFont>
+#include <QPointer>
+#include <grouplistwidget/grouppixmappyramid.h>
+#include <grouplistwidget/groupmodel.h>
 
 class GroupListWidget;
-class GroupModel;
 
 //! Allows user to customize parts of the GroupModel.
 class GROUPLISTWIDGET_EXPORT GroupListDelegate : public QStyledItemDelegate/* QAbstractItemDelegate */ {
@@ -54,6 +60,48 @@ public:
         return item_size_;
     }
 
+    //! The downscaled versions of the images used while painting.
+    GroupPixmapPyramid &
+    pixmapPyramid () const {
+        return pyramid_;
+    }
+
+    //! Maximum number of items that have their labels cached.
+    int
+    textCacheSize () const {
+        return text_cache_.maxCost ();
+    }
+
+    //! Change the maximum number of items that have their labels cached.
+    void
+    setTextCacheSize (
+            int value) {
+        text_cache_.setMaxCost (value);
+    }
+
+    //! Number of items painted with labels from the text cache.
+    int
+    textCacheHits () const {
+        return text_hits_;
+    }
+
+    //! Number of items that had their labels laid out while painting.
+    int
+    textCacheMisses () const {
+        return text_misses_;
+    }
+
+    //! Account the cached labels and image levels.
+    void
+    addMemoryUsage (
+            GroupMemoryUsage * usage) const;
+
+public slots:
+
+    //! Drop all cached labels.
+    void
+    clearTextCache ();
+
 protected:
 
     void
@@ -67,13 +115,40 @@ protected:
             const QStyleOptionViewItem & option,
             const QModelIndex & index ) const;
 
+private slots:
+
+    //! Drop cached labels for the rows that changed in base model.
+    void
+    baseModelDataChange (
+            const QModelIndex &topLeft,
+            const QModelIndex &bottomRight,
+            const QVector<int> &roles = QVector<int>());
 
 private:
+
+    //! Lay out the labels of an item.
+    QVector<QStaticText>
+    createLabels (
+            const QVariantList & values) const;
+
+    //! Start following the changes in a base model.
+    void
+    setBaseModel (
+            QAbstractItemModel * model);
+
     QSize item_size_; /**< cached size of the entire item */
     QRect pix_pos_; /**< the position of the pixmap inside the item rect */
     QRect text_pos_; /**< the position of the first label inside the item rect */
     Layout layout_; /**< the way internal components are arranged */
     int lay_count_; /**< the number of labels to show */
+    mutable GroupPixmapPyramid pyramid_; /**< downscaled versions of the images */
+    QFont font_main_; /**< the font used for first label */
+    QFont font_other_; /**< the font used for all other labels */
+    QList<ModelId> labels_; /**< column and role for each label */
+    QPointer<QAbstractItemModel> base_; /**< base model providing the labels */
+    mutable QCache<int, QVector<QStaticText> > text_cache_; /**< laid out labels by row in base model */
+    mutable int text_hits_; /**< items painted with cached labels */
+    mutable int text_misses_; /**< items that had their labels laid out */
 
 public: virtual void anchorVtable() const;
 }; // class GroupListDelegate
@@ -10,19 +10,61 @@
 #include "grouplistgroup.h"
 #include "grouplistwidget.h"
 #include "groupmodel.h"
+#include "groupmemoryusage.h"
+#include "groupselection.h"
+#include "groupselectionmodel.h"
 #include "groupsubmodel.h"
+#include "grouptracer.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+#include <QHoverEvent>
+#include <QPixmap>
+#include <QElapsedTimer>
+#include <QItemSelectionModel>
 
 
 /**
  * @class GroupListGroup
  *
- * .
+ * The lists are sized to show all their content, so they never scroll
+ * by themselves; the tree hosting them does.
+ *
+ * When GroupListWidget::tileCaching() is on, the items are painted into
+ * fixed-size tiles at the device pixel ratio of the screen and the tiles are
+ * blitted in subsequent paint events. Tiles are stored in QPixmapCache,
+ * so all the lists share the budget set by QPixmapCache::setCacheLimit().
+ * Tiles showing an item are dropped when the data or the hover state of
+ * that item changes; all tiles are dropped when the shared selection, the
+ * geometry, the palette, the font or the model changes.
+ *
+ * The selection state of the items is read from the GroupSelection of
+ * the widget through a GroupSelectionModel, so the items are always
+ * painted by this class and not by QListView.
  */
 
+//! Pack the position of a tile into a key.
+static inline quint64 tileKey (int tx, int ty)
+{
+    return (static_cast<quint64> (static_cast<quint32> (tx)) << 32) |
+            static_cast<quint32> (ty);
+}
+
+//! Division that rounds towards negative infinity.
+static inline int floorDiv (int value, int divisor)
+{
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
 
 GroupListGroup::GroupListGroup (GroupListWidget * parent) :
     QListView (),
-    parent_(parent)
+    parent_(parent),
+    tiles_(),
+    tiles_dpr_(1.0),
+    tiles_selection_(0),
+    hover_(),
+    drag_command_(QItemSelectionModel::NoUpdate)
 {
     setUniformItemSizes (true);
 #   if 1 // ndef GROUPLISTWIDGET_DEBUG
@@ -35,6 +77,7 @@ GroupListGroup::GroupListGroup (GroupListWidget * parent) :
     setMovement (QListView::Static);
     setFlow (parent_->flow());
     setWrapping (true);
+    setSelectionMode (parent_->listSelectionMode ());
     int c = parent_->underModel ()->label ().column ();
     if (c != -1)
         setModelColumn (c);
@@ -46,4 +89,436 @@ GroupListGroup::GroupListGroup (GroupListWidget * parent) :
     }
 }
 
+/* ------------------------------------------------------------------------- */
+void GroupListGroup::clearTiles ()
+{
+    foreach (const QPixmapCache::Key & key, tiles_) {
+        QPixmapCache::remove (key);
+    }
+    tiles_.clear ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+qint64 GroupListGroup::tileBytes () const
+{
+    qint64 result = 0;
+    foreach (const QPixmapCache::Key & key, tiles_) {
+        QPixmap pix;
+        if (QPixmapCache::find (key, &pix))
+            result += GroupMemoryUsage::pixmapBytes (pix);
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListGroup::reset ()
+{
+    clearTiles ();
+    QListView::reset ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListGroup::doItemsLayout ()
+{
+    clearTiles ();
+    QListView::doItemsLayout ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListGroup::paintEvent (QPaintEvent * event)
+{
+    GROUPLISTWIDGET_TRACE_SCOPE("GroupListGroup::paintEvent");
+    GroupFrameStats * stats = parent_->frameStats ();
+    if (stats == NULL) {
+        paintItems (event, NULL);
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start ();
+    paintItems (event, stats);
+    stats->addPaintNs (timer.nsecsElapsed ());
+    stats->add (GroupFrameStats::CounterPaintEvents);
+    stats->add (GroupFrameStats::CounterListsPainted);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListGroup::paintItems (QPaintEvent * event, GroupFrameStats * stats)
+{
+    if (model () == NULL)
+        return;
+    if (!parent_->tileCaching ()) {
+        QPainter painter (viewport ());
+        paintRange (painter, event->rect (), stats);
+        return;
+    }
+
+    qreal dpr = viewport ()->devicePixelRatioF ();
+    quint64 serial = parent_->selection ()->serial ();
+    if ((dpr != tiles_dpr_) || (serial != tiles_selection_)) {
+        clearTiles ();
+        tiles_dpr_ = dpr;
+        tiles_selection_ = serial;
+    }
+
+    // tiles are positioned in content coordinates
+    int ts = tileSize ();
+    QPoint offset (horizontalOffset (), verticalOffset ());
+    QRect area = event->rect ().translated (offset);
+    int tx_min = floorDiv (area.left (), ts);
+    int tx_max = floorDiv (area.right (), ts);
+    int ty_min = floorDiv (area.top (), ts);
+    int ty_max = floorDiv (area.bottom (), ts);
+
+    QPainter painter (viewport ());
+    for (int ty = ty_min; ty <= ty_max; ++ty) {
+        for (int tx = tx_min; tx <= tx_max; ++tx) {
+            QRect vp_rect = QRect (tx * ts, ty * ts, ts, ts).translated (-offset);
+            quint64 key = tileKey (tx, ty);
+            QPixmap pix;
+            if (!tiles_.contains (key) ||
+                    !QPixmapCache::find (tiles_.value (key), &pix)) {
+                pix = renderTile (vp_rect, dpr, stats);
+                tiles_.insert (key, QPixmapCache::insert (pix));
+                if (stats != NULL)
+                    stats->add (GroupFrameStats::CounterTileMisses);
+            } else if (stats != NULL) {
+                stats->add (GroupFrameStats::CounterTileHits);
+            }
+            painter.drawPixmap (vp_rect.topLeft (), pix);
+        }
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QPixmap GroupListGroup::renderTile (
+        const QRect & vp_rect, qreal dpr, GroupFrameStats * stats)
+{
+    GROUPLISTWIDGET_TRACE_SCOPE("GroupListGroup::renderTile");
+    QPixmap pix (vp_rect.size () * dpr);
+    pix.setDevicePixelRatio (dpr);
+    pix.fill (Qt::transparent);
+
+    QPainter painter (&pix);
+    painter.fillRect (
+                QRect (QPoint (0, 0), vp_rect.size ()),
+                viewport ()->palette ().brush (viewport ()->backgroundRole ()));
+    painter.translate (-vp_rect.topLeft ());
+    paintRange (painter, vp_rect, stats);
+    return pix;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The items are painted the same way QListView does it, but only the
+ * ones that intersect the rectangle are considered. As the items have
+ * uniform sizes and are laid out in model order the range is found using
+ * binary searches.
+ */
+void GroupListGroup::paintRange (
+        QPainter & painter, const QRect & vp_rect, GroupFrameStats * stats)
+{
+    QAbstractItemModel * mdl = model ();
+    const GroupSelectionModel * sel =
+            qobject_cast<const GroupSelectionModel *>(selectionModel ());
+    QStyleOptionViewItem option = viewOptions ();
+    const QStyle::State state = option.state;
+    const bool enabled = (state & QStyle::State_Enabled) != 0;
+    const QModelIndex current = currentIndex ();
+    const bool focus =
+            (hasFocus () || viewport ()->hasFocus ()) && current.isValid ();
+
+    int first;
+    int last;
+    if (flow () == QListView::LeftToRight) {
+        first = firstRowEndingAfter (vp_rect.top ());
+        last = firstRowStartingAfter (vp_rect.bottom ());
+    } else {
+        first = firstRowEndingAfter (vp_rect.left ());
+        last = firstRowStartingAfter (vp_rect.right ());
+    }
+
+    for (int i = first; i < last; ++i) {
+        QModelIndex idx = mdl->index (i, modelColumn (), rootIndex ());
+        QRect r = visualRect (idx);
+        if (!r.intersects (vp_rect))
+            continue;
+
+        option.rect = r;
+        option.state = state;
+        if ((sel != NULL) && sel->isRowSelected (i))
+            option.state |= QStyle::State_Selected;
+        if (enabled) {
+            if ((mdl->flags (idx) & Qt::ItemIsEnabled) == 0) {
+                option.state &= ~QStyle::State_Enabled;
+                option.palette.setCurrentColorGroup (QPalette::Disabled);
+            } else {
+                option.palette.setCurrentColorGroup (QPalette::Normal);
+            }
+        }
+        if (focus && (current == idx))
+            option.state |= QStyle::State_HasFocus;
+        if (idx == hover_)
+            option.state |= QStyle::State_MouseOver;
+        else
+            option.state &= ~QStyle::State_MouseOver;
+
+        itemDelegate (idx)->paint (&painter, option, idx);
+        if (stats != NULL)
+            stats->add (GroupFrameStats::CounterItemsPainted);
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int GroupListGroup::firstRowEndingAfter (int pos) const
+{
+    QAbstractItemModel * mdl = model ();
+    int lo = 0;
+    int hi = mdl->rowCount (rootIndex ());
+    bool ltr = (flow () == QListView::LeftToRight);
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        QRect r = visualRect (mdl->index (mid, modelColumn (), rootIndex ()));
+        int end = ltr ? r.bottom () : r.right ();
+        if (end < pos) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int GroupListGroup::firstRowStartingAfter (int pos) const
+{
+    QAbstractItemModel * mdl = model ();
+    int lo = 0;
+    int hi = mdl->rowCount (rootIndex ());
+    bool ltr = (flow () == QListView::LeftToRight);
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        QRect r = visualRect (mdl->index (mid, modelColumn (), rootIndex ()));
+        int start = ltr ? r.top () : r.left ();
+        if (start <= pos) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListGroup::invalidateRect (const QRect & vp_rect)
+{
+    if (tiles_.isEmpty () || vp_rect.isEmpty ())
+        return;
+    int ts = tileSize ();
+    QRect area = vp_rect.translated (horizontalOffset (), verticalOffset ());
+    int tx_max = floorDiv (area.right (), ts);
+    int ty_max = floorDiv (area.bottom (), ts);
+    for (int ty = floorDiv (area.top (), ts); ty <= ty_max; ++ty) {
+        for (int tx = floorDiv (area.left (), ts); tx <= tx_max; ++tx) {
+            quint64 key = tileKey (tx, ty);
+            QHash<quint64, QPixmapCache::Key>::iterator it = tiles_.find (key);
+            if (it != tiles_.end ()) {
+                QPixmapCache::remove (it.value ());
+                tiles_.erase (it);
+            }
+        }
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListGroup::invalidateRows (int first, int last)
+{
+    if (tiles_.isEmpty () || (model () == NULL))
+        return;
+    // past a certain point it is cheaper to start from scratch
+    if (last - first > 256) {
+        clearTiles ();
+        return;
+    }
+    for (int i = first; i <= last; ++i) {
+        invalidateRect (visualRect (
+                            model ()->index (i, modelColumn (), rootIndex ())));
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListGroup::resizeEvent (QResizeEvent * event)
+{
+    clearTiles ();
+    QListView::resizeEvent (event);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListGroup::changeEvent (QEvent * event)
+{
+    switch (event->type ()) {
+    case QEvent::FontChange:
+    case QEvent::PaletteChange:
+    case QEvent::StyleChange:
+    case QEvent::EnabledChange:
+    case QEvent::ActivationChange:
+        clearTiles ();
+        break;
+    default:
+        break;
+    }
+    QListView::changeEvent (event);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The item under the mouse is tracked here, as the one tracked by
+ * QAbstractItemView is private; the tiles showing the items that gain
+ * or lose the hover state are dropped.
+ */
+bool GroupListGroup::viewportEvent (QEvent * event)
+{
+    switch (event->type ()) {
+    case QEvent::HoverEnter:
+    case QEvent::HoverMove:
+    case QEvent::HoverLeave: {
+        QModelIndex idx;
+        if (event->type () != QEvent::HoverLeave)
+            idx = indexAt (static_cast<QHoverEvent *>(event)->pos ());
+        if (idx != hover_) {
+            invalidateRect (visualRect (hover_));
+            invalidateRect (visualRect (idx));
+            hover_ = idx;
+        }
+        break; }
+    default:
+        break;
+    }
+    return QListView::viewportEvent (event);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListGroup::focusInEvent (QFocusEvent * event)
+{
+    invalidateRect (visualRect (currentIndex ()));
+    QListView::focusInEvent (event);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListGroup::focusOutEvent (QFocusEvent * event)
+{
+    invalidateRect (visualRect (currentIndex ()));
+    QListView::focusOutEvent (event);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListGroup::dataChanged (
+        const QModelIndex & topLeft, const QModelIndex & bottomRight,
+        const QVector<int> & roles)
+{
+    invalidateRows (topLeft.row (), bottomRight.row ());
+    QListView::dataChanged (topLeft, bottomRight, roles);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListGroup::rowsInserted (
+        const QModelIndex & parent, int start, int end)
+{
+    clearTiles ();
+    QListView::rowsInserted (parent, start, end);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListGroup::rowsAboutToBeRemoved (
+        const QModelIndex & parent, int start, int end)
+{
+    clearTiles ();
+    QListView::rowsAboutToBeRemoved (parent, start, end);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QModelIndexList GroupListGroup::selectedIndexes () const
+{
+    const GroupSelectionModel * sel =
+            qobject_cast<const GroupSelectionModel *>(selectionModel ());
+    if (sel == NULL)
+        return QListView::selectedIndexes ();
+    return sel->selectedRowIndexes (modelColumn ());
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * QAbstractItemView turns a Toggle on mouse press into Select or Deselect
+ * by asking the selection model, which holds no state here; the decision
+ * is taken using the shared selection instead and reused while the mouse
+ * is dragged.
+ */
+QItemSelectionModel::SelectionFlags GroupListGroup::selectionCommand (
+        const QModelIndex & index, const QEvent * event) const
+{
+    QItemSelectionModel::SelectionFlags result =
+            QListView::selectionCommand (index, event);
+    const GroupSelectionModel * sel =
+            qobject_cast<const GroupSelectionModel *>(selectionModel ());
+    if ((sel == NULL) || (event == NULL))
+        return result;
+
+    const QItemSelectionModel::SelectionFlags behavior =
+            result & (QItemSelectionModel::Rows | QItemSelectionModel::Columns);
+    switch (event->type ()) {
+    case QEvent::MouseButtonPress:
+        drag_command_ = QItemSelectionModel::NoUpdate;
+        if ((result & QItemSelectionModel::Toggle) != 0) {
+            drag_command_ = sel->isRowSelected (index.row ()) ?
+                        QItemSelectionModel::Deselect :
+                        QItemSelectionModel::Select;
+            result = drag_command_ | behavior;
+        }
+        break;
+    case QEvent::MouseMove:
+        if ((drag_command_ != QItemSelectionModel::NoUpdate) &&
+                ((result & QItemSelectionModel::Current) != 0) &&
+                ((result & (QItemSelectionModel::Select |
+                            QItemSelectionModel::Deselect)) == 0)) {
+            result = drag_command_ | QItemSelectionModel::Current | behavior;
+        }
+        break;
+    default:
+        break;
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListGroup::currentChanged (
+        const QModelIndex & current, const QModelIndex & previous)
+{
+    invalidateRect (visualRect (previous));
+    invalidateRect (visualRect (current));
+    QListView::currentChanged (current, previous);
+}
+/* ========================================================================= */
+
 void GroupListGroup::anchorVtable () const {}
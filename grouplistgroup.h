@@ -12,8 +12,13 @@
 
 #include <grouplistwidget/grouplistwidget-config.h>
 #include <QListView>
+#include <QItemSelectionModel>
+#include <QHash>
+#include <QPixmapCache>
 
 class GroupListWidget;
+class GroupFrameStats;
+class QPainter;
 
 //! Represents a list widget inside the tree presenting the content of a group.
 class GROUPLISTWIDGET_EXPORT GroupListGroup : public QListView {
@@ -28,6 +33,138 @@ public:
         return QListView::viewOptions();
     }
 
+    //! Forget all rendered tiles.
+    void
+    clearTiles ();
+
+    //! Number of rendered tiles that are kept.
+    int
+    tileCount () const {
+        return tiles_.count ();
+    }
+
+    //! Memory used by the rendered tiles that are still in QPixmapCache.
+    qint64
+    tileBytes () const;
+
+    //! The size of a tile in logical pixels.
+    static int
+    tileSize () {
+        return 256;
+    }
+
+    virtual void
+    reset ();
+
+    virtual void
+    doItemsLayout ();
+
+protected:
+
+    virtual void
+    paintEvent (
+            QPaintEvent * event);
+
+    virtual void
+    resizeEvent (
+            QResizeEvent * event);
+
+    virtual void
+    changeEvent (
+            QEvent * event);
+
+    virtual bool
+    viewportEvent (
+            QEvent * event);
+
+    virtual void
+    focusInEvent (
+            QFocusEvent * event);
+
+    virtual void
+    focusOutEvent (
+            QFocusEvent * event);
+
+    virtual void
+    dataChanged (
+            const QModelIndex &topLeft,
+            const QModelIndex &bottomRight,
+            const QVector<int> &roles = QVector<int>());
+
+    virtual void
+    rowsInserted (
+            const QModelIndex &parent,
+            int start,
+            int end);
+
+    virtual void
+    rowsAboutToBeRemoved (
+            const QModelIndex &parent,
+            int start,
+            int end);
+
+    virtual QModelIndexList
+    selectedIndexes () const;
+
+    virtual QItemSelectionModel::SelectionFlags
+    selectionCommand (
+            const QModelIndex &index,
+            const QEvent *event = NULL) const;
+
+    virtual void
+    currentChanged (
+            const QModelIndex &current,
+            const QModelIndex &previous);
+
+private:
+
+    //! Paint the items, directly or from the tiles.
+    void
+    paintItems (
+            QPaintEvent * event,
+            GroupFrameStats * stats);
+
+    //! Paint the items that intersect a rectangle into a pixmap.
+    QPixmap
+    renderTile (
+            const QRect & vp_rect,
+            qreal dpr,
+            GroupFrameStats * stats);
+
+    //! Paint the items that intersect a rectangle in viewport coordinates.
+    void
+    paintRange (
+            QPainter & painter,
+            const QRect & vp_rect,
+            GroupFrameStats * stats);
+
+    //! Forget the tiles that intersect a rectangle in viewport coordinates.
+    void
+    invalidateRect (
+            const QRect & vp_rect);
+
+    //! Forget the tiles showing the items in a range of rows.
+    void
+    invalidateRows (
+            int first,
+            int last);
+
+    //! First row that ends after a position along the wrapping direction.
+    int
+    firstRowEndingAfter (
+            int pos) const;
+
+    //! First row that starts after a position along the wrapping direction.
+    int
+    firstRowStartingAfter (
+            int pos) const;
+
+    QHash<quint64, QPixmapCache::Key> tiles_; /**< rendered tiles by their position */
+    qreal tiles_dpr_; /**< the device pixel ratio used for the tiles */
+    quint64 tiles_selection_; /**< GroupSelection::serial() when the tiles were rendered */
+    QPersistentModelIndex hover_; /**< the item under the mouse */
+    mutable QItemSelectionModel::SelectionFlags drag_command_; /**< what a mouse drag started with Ctrl does */
+
 public: virtual void anchorVtable() const;
 }; // class GroupListDelegate
 
@@ -20,17 +20,88 @@
 #   define DEBUG_ON 1
 #endif // DEBUG_ON
 
+#include <QLoggingCategory>
+#include <QAtomicInteger>
+#include <QDateTime>
 
-#if DEBUG_ON
-#    define GROUPLISTWIDGET_DEBUGM printf
+Q_DECLARE_LOGGING_CATEGORY(grpLogModel)
+Q_DECLARE_LOGGING_CATEGORY(grpLogCompare)
+Q_DECLARE_LOGGING_CATEGORY(grpLogView)
+Q_DECLARE_LOGGING_CATEGORY(grpLogDelegate)
+Q_DECLARE_LOGGING_CATEGORY(grpLogTrace)
+
+//! Lets a few messages from one place through each second.
+class GroupLogLimiter {
+public:
+    GroupLogLimiter () :
+        window_start_(0), in_window_(0), suppressed_(0)
+    {}
+
+    //! Should a message be printed? Reports the ones dropped in last window.
+    bool
+    allow (
+            const QLoggingCategory & category,
+            QtMsgType type) {
+        qint64 now = QDateTime::currentMSecsSinceEpoch ();
+        qint64 start = window_start_.load ();
+        if ((now - start >= 1000) &&
+                window_start_.testAndSetRelaxed (start, now)) {
+            in_window_.store (0);
+            int dropped = suppressed_.fetchAndStoreRelaxed (0);
+            if (dropped > 0) {
+                QMessageLogger logger (
+                            __FILE__, __LINE__, Q_FUNC_INFO,
+                            category.categoryName ());
+                if (type == QtDebugMsg)
+                    logger.debug (category, "(%d similar messages suppressed)", dropped);
+                else
+                    logger.warning (category, "(%d similar messages suppressed)", dropped);
+            }
+        }
+        if (in_window_.fetchAndAddRelaxed (1) < limit ())
+            return true;
+        suppressed_.fetchAndAddRelaxed (1);
+        return false;
+    }
+
+    //! Number of messages allowed each second.
+    static int
+    limit () {
+        return 10;
+    }
+
+private:
+    QAtomicInteger<qint64> window_start_; /**< start of current window (ms) */
+    QAtomicInt in_window_; /**< messages seen in current window */
+    QAtomicInt suppressed_; /**< messages dropped in current window */
+};
+
+// The arguments are only evaluated when the category is enabled
+// for that level; each call site has its own limiter.
+#define GROUPLISTWIDGET_LOG_IMPL(__cat__, __type__, __fun__, ...) \
+    do { \
+        const QLoggingCategory & grp_log_cat_ = __cat__ (); \
+        if (grp_log_cat_.isEnabled (__type__)) { \
+            static GroupLogLimiter grp_log_limiter_; \
+            if (grp_log_limiter_.allow (grp_log_cat_, __type__)) \
+                QMessageLogger (__FILE__, __LINE__, Q_FUNC_INFO, \
+                                grp_log_cat_.categoryName ()).__fun__ ( \
+                                    grp_log_cat_, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#ifndef QT_NO_WARNING_OUTPUT
+#    define GROUPLISTWIDGET_LOG_WARNING(__cat__, ...) \
+         GROUPLISTWIDGET_LOG_IMPL(__cat__, QtWarningMsg, warning, __VA_ARGS__)
 #else
-#    define GROUPLISTWIDGET_DEBUGM black_hole
+#    define GROUPLISTWIDGET_LOG_WARNING(__cat__, ...) do {} while (0)
 #endif
 
-#if DEBUG_OFF
-#    define GROUPLISTWIDGET_DEBUGV printf
+#ifndef QT_NO_DEBUG_OUTPUT
+#    define GROUPLISTWIDGET_LOG_DEBUG(__cat__, ...) \
+         GROUPLISTWIDGET_LOG_IMPL(__cat__, QtDebugMsg, debug, __VA_ARGS__)
 #else
-#    define GROUPLISTWIDGET_DEBUGV black_hole
+#    define GROUPLISTWIDGET_LOG_DEBUG(__cat__, ...) do {} while (0)
 #endif
 
 #if DEBUG_OFF
@@ -45,9 +116,21 @@
 #    define GROUPLISTWIDGET_TRACE_EXIT
 #endif
 
-
-static inline void black_hole (...)
-{}
+#ifdef GROUPLISTWIDGET_STATS
+#    include <grouplistwidget/groupmodelstats.h>
+#    define GROUPLISTWIDGET_STATS_OPERATION(__m__, __name__) \
+         GroupStatsOperation grp_stats_operation_ (__m__, __name__)
+#    define GROUPLISTWIDGET_STATS_PHASE(__m__, __phase__) \
+         GroupStatsPhase grp_stats_phase_ (__m__, GroupModelStats::__phase__)
+#    define GROUPLISTWIDGET_STATS_COUNT(__m__, __counter__, __n__) \
+         (__m__)->statsCount (GroupModelStats::__counter__, __n__)
+#    define GROUPLISTWIDGET_STATS_ONLY(__x__) __x__
+#else
+#    define GROUPLISTWIDGET_STATS_OPERATION(__m__, __name__)
+#    define GROUPLISTWIDGET_STATS_PHASE(__m__, __phase__)
+#    define GROUPLISTWIDGET_STATS_COUNT(__m__, __counter__, __n__)
+#    define GROUPLISTWIDGET_STATS_ONLY(__x__)
+#endif
 
 
 #endif // GUARD_GROUPLISTWIDGET_PRIVATE_H_INCLUDE
@@ -12,6 +12,10 @@
 #include "groupsubmodel.h"
 #include "grouplistgroup.h"
 #include "grouplistdelegate.h"
+#include "groupselection.h"
+#include "groupselectionmodel.h"
+#include "groupgeometrycache.h"
+#include "grouptracer.h"
 
 #include "grouplistwidget-private.h"
 
@@ -20,11 +24,16 @@
 #include <QMenu>
 #include <QContextMenuEvent>
 #include <QStyledItemDelegate>
-#include <QFontMetrics>
+#include <QStyle>
 #include <QWheelEvent>
 #include <QPixmap>
 #include <QImage>
 #include <QPainter>
+#include <QScrollBar>
+#include <QTimer>
+#include <QPixmapCache>
+#include <QLabel>
+#include <QDataStream>
 
 
 #define GEN_SLOT_FUN "gsfunction"
@@ -49,19 +58,76 @@ public:
     int group_index_;
     GroupListGroup * lv_;
     GroupSubModel * gsm_;
+    qint64 last_seen_; /**< last time the group was visible (lazy mode) */
+    QString key_; /**< identifies the group across rebuilds */
+    QPixmapCache::Key header_key_; /**< the rendered header in QPixmapCache */
+    int header_generation_; /**< GroupListWidget::headerCacheGeneration() for the header */
+    QSize header_size_; /**< the size of the rendered header */
+    bool header_open_; /**< the rendered header is expanded */
+    qint64 header_palette_; /**< the key of the palette used for the header */
+    qreal header_dpr_; /**< device pixel ratio of the rendered header */
+    QString header_label_; /**< the label on the rendered header */
 
     GrpTreeItem (const QString & label, int idx, GroupSubModel * gsm) :
         QTreeWidgetItem (QStringList () << label ),
         group_index_ (idx),
         lv_(NULL),
-        gsm_(gsm)
+        gsm_(gsm),
+        last_seen_(0),
+        key_(),
+        header_key_(),
+        header_generation_(-1),
+        header_size_(),
+        header_open_(false),
+        header_palette_(0),
+        header_dpr_(0.0),
+        header_label_()
     {
     }
+
+    //! Was the header rendered with these settings?
+    bool
+    headerMatches (
+            int generation, const QSize & size, bool b_open,
+            qint64 palette, qreal dpr, const QString & label) const {
+        return (header_generation_ == generation) &&
+                (header_size_ == size) &&
+                (header_open_ == b_open) &&
+                (header_palette_ == palette) &&
+                (header_dpr_ == dpr) &&
+                (header_label_ == label);
+    }
 public: virtual void anchorVtable() const;
 };
 void GrpTreeItem::anchorVtable() const {}
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+//! A string that identifies a group across rebuilds.
+//!
+//! Keys without a string form (QSize, QRect, ...) are told apart by
+//! their streamed value; custom types that may not be streamable fall
+//! back to the position of the group.
+static QString groupStateKey (const GroupSubModel * gsm)
+{
+    const QVariant & key = gsm->groupKey ();
+    QString result = QString::number (key.userType ()) + QLatin1Char (':');
+    if (!key.isValid () || key.canConvert<QString> ()) {
+        result.append (key.toString ());
+    } else if (key.userType () < QMetaType::User) {
+        QByteArray bytes;
+        QDataStream stream (&bytes, QIODevice::WriteOnly);
+        stream << key;
+        result.append (QLatin1Char ('#'));
+        result.append (QString::fromLatin1 (bytes.toHex ()));
+    } else {
+        result.append (QLatin1Char ('@'));
+        result.append (QString::number (gsm->listIndex ()));
+    }
+    return result;
+}
+/* ========================================================================= */
+
 /* ------------------------------------------------------------------------- */
 //! Delegate for QTreeWidget.
 class GrpTreeDeleg : public QStyledItemDelegate {
@@ -100,56 +166,101 @@ public:
         }
     }
 
+    //! Paint a group header at the position given by the option.
+    void paintHeader (
+            QPainter *painter, const QStyleOptionViewItem &option,
+            const QString & label) const
+    {
+        GroupListWidget * g = glw ();
+        painter->setBrush (QBrush (g->groupBackColor ()));
+        painter->setFont (option.font);
+        painter->setPen (Qt::NoPen);
+
+        painter->drawRect (option.rect);
+        painter->setPen (Qt::SolidLine);
+
+        QRect ricon = option.rect;
+        ricon.setSize (option.decorationSize);
+        QRect rtext = option.rect;
+
+        const QIcon & icn = (option.state & QStyle::State_Open) ?
+                    g->iconExpanded () : g->iconCollapsed ();
+        if (!icn.isNull()) {
+            icn.paint (
+                        painter, ricon,
+                        option.decorationAlignment, QIcon::Normal);
+            rtext.translate (ricon.width(), 0);
+            rtext.setWidth (rtext.width() - ricon.width());
+        }
+
+        QRect text_out;
+        painter->drawText (
+                    rtext,
+                    Qt::AlignTop|Qt::AlignLeft,
+                    label,
+                    &text_out);
+
+        int top_pos_l = text_out.top() + text_out.height() / 2 + 1;
+        painter->drawLine (
+                    QPoint (text_out.right () + ricon.width(), top_pos_l),
+                    QPoint (rtext.right () - ricon.width(), top_pos_l));
+    }
+
+    //! Group headers are painted once and then served from QPixmapCache.
+    //!
+    //! The key of the pixmap is stored in the item together with the
+    //! settings it was rendered with, so a hit does not allocate.
     void paint (
             QPainter *painter, const QStyleOptionViewItem &option,
             const QModelIndex &index) const
     {
+        GROUPLISTWIDGET_TRACE_SCOPE("GrpTreeDeleg::paint");
         GroupListWidget * g = glw ();
-        if (g && !index.parent ().isValid()) {
-            /*bool selected =
-                    (option.state & QStyle::State_Selected) == QStyle::State_Selected;
-            if (selected) {
-                painter->setBrush (option.palette.brush (QPalette::Highlight));
+        GrpTreeItem * it = (g == NULL) || index.parent ().isValid () ? NULL :
+                static_cast<GrpTreeItem *>(g->itemFromIndex (index));
+        if (it != NULL) {
+            if (option.rect.isEmpty ())
+                return;
+            QString label = index.data (Qt::DisplayRole).toString();
+            qreal dpr = painter->device ()->devicePixelRatioF ();
+            bool b_open = (option.state & QStyle::State_Open) != 0;
+            int generation = g->headerCacheGeneration ();
+            qint64 palette = option.palette.cacheKey ();
+
+            GroupFrameStats * stats = g->frameStats ();
+            if (stats != NULL)
+                stats->add (GroupFrameStats::CounterHeadersPainted);
+
+            QPixmap pm;
+            if (it->headerMatches (generation, option.rect.size (), b_open,
+                                   palette, dpr, label) &&
+                    QPixmapCache::find (it->header_key_, &pm)) {
+                if (stats != NULL)
+                    stats->add (GroupFrameStats::CounterHeaderHits);
             } else {
-                painter->setBrush (QBrush (group_back_)); //(option.backgroundBrush);
-            }*/
-            painter->setBrush (QBrush (g->groupBackColor ()));
-            painter->setFont (option.font);
-            painter->setPen (Qt::NoPen);
-
-            painter->drawRect (option.rect);
-            painter->setPen (Qt::SolidLine);
-
-            QRect ricon = option.rect;
-            ricon.setSize (option.decorationSize);
-            QRect rtext = option.rect;
-
-            QIcon icn;
-            if (option.state & QStyle::State_Open) {
-                icn = g->iconExpanded ();
-            } else {
-                icn = g->iconCollapsed ();
-            }
-            if (!icn.isNull()) {
-                icn.paint (
-                            painter, ricon,
-                            option.decorationAlignment, QIcon::Normal);
-                rtext.translate (ricon.width(), 0);
-                rtext.setWidth (rtext.width() - ricon.width());
+                if (stats != NULL)
+                    stats->add (GroupFrameStats::CounterHeaderMisses);
+                pm = QPixmap (option.rect.size () * dpr);
+                pm.setDevicePixelRatio (dpr);
+                pm.fill (Qt::transparent);
+
+                QStyleOptionViewItem opt (option);
+                opt.rect.moveTo (0, 0);
+                QPainter pmp (&pm);
+                paintHeader (&pmp, opt, label);
+                pmp.end ();
+
+                // the old pixmap can not be reached any longer
+                QPixmapCache::remove (it->header_key_);
+                it->header_key_ = QPixmapCache::insert (pm);
+                it->header_generation_ = generation;
+                it->header_size_ = option.rect.size ();
+                it->header_open_ = b_open;
+                it->header_palette_ = palette;
+                it->header_dpr_ = dpr;
+                it->header_label_ = label;
             }
-
-            QRect text_out;
-            painter->drawText (
-                        rtext,
-                        Qt::AlignTop|Qt::AlignLeft,
-                        index.data (Qt::DisplayRole).toString(),
-                        &text_out);
-
-            int top_pos_l = text_out.top() + text_out.height() / 2 + 1;
-            painter->drawLine (
-                        QPoint (text_out.right () + ricon.width(), top_pos_l),
-                        QPoint (rtext.right () - ricon.width(), top_pos_l));
-
+            painter->drawPixmap (option.rect.topLeft (), pm);
             return;
         } else if (prev_ != NULL) {
             prev_->paint (painter, option, index);
@@ -199,7 +310,43 @@ GroupListWidget::GroupListWidget (QWidget *parent) :
     current_row_(-1),
     icon_group_expanded_(),
     icon_group_collapsed_(),
-    group_back_(179, 230, 255)
+    group_back_(179, 230, 255),
+    header_generation_(0),
+    geometry_cache_(GroupGeometryCache::global ()),
+    tile_caching_(false),
+    lazy_views_(false),
+    lazy_release_ms_(5000),
+    view_pool_size_(32),
+    updates_held_(false),
+    updates_were_enabled_(true),
+    progressive_(false),
+    slice_budget_ms_(10),
+    populate_next_(0),
+    collapsed_keys_(),
+    anchor_key_(),
+    anchor_offset_(0),
+    saved_row_(-1),
+    state_saved_(false),
+    restoring_(false),
+    materialize_timer_(new QTimer (this)),
+    release_timer_(new QTimer (this)),
+    populate_timer_(new QTimer (this)),
+    arrange_timer_(new QTimer (this)),
+    arrange_pending_(),
+    selection_(new GroupSelection (this)),
+    selection_base_(),
+    current_lv_(),
+    list_selection_mode_(QAbstractItemView::SingleSelection),
+    clock_(),
+    diagnostics_(false),
+    frame_open_(false),
+    frame_count_(0),
+    frame_(),
+    frame_base_(),
+    last_frame_(),
+    frame_timer_(new QTimer (this)),
+    overlay_(NULL),
+    overlay_timer_(new QTimer (this))
 
 {
     GROUPLISTWIDGET_TRACE_ENTRY;
@@ -208,6 +355,36 @@ GroupListWidget::GroupListWidget (QWidget *parent) :
     setVerticalScrollMode (QAbstractItemView::ScrollPerPixel);
     installUnderModel (m_);
     connect(this, &QTreeView::clicked, this, &GroupListWidget::itemClicked);
+
+    clock_.start ();
+    materialize_timer_->setSingleShot (true);
+    materialize_timer_->setInterval (0);
+    connect (materialize_timer_, &QTimer::timeout,
+             this, &GroupListWidget::materializeVisible);
+    populate_timer_->setInterval (0);
+    connect (populate_timer_, &QTimer::timeout,
+             this, &GroupListWidget::populateSlice);
+    connect (release_timer_, &QTimer::timeout,
+             this, &GroupListWidget::releaseHidden);
+    arrange_timer_->setSingleShot (true);
+    arrange_timer_->setInterval (0);
+    connect (arrange_timer_, &QTimer::timeout,
+             this, &GroupListWidget::arangePending);
+    frame_timer_->setSingleShot (true);
+    frame_timer_->setInterval (0);
+    connect (frame_timer_, &QTimer::timeout,
+             this, &GroupListWidget::endFrame);
+    overlay_timer_->setSingleShot (true);
+    overlay_timer_->setInterval (250);
+    connect (overlay_timer_, &QTimer::timeout,
+             this, &GroupListWidget::updateOverlay);
+    connect (selection_, &GroupSelection::selectionChanged,
+             this, &GroupListWidget::crossSelectionChange);
+    connect (verticalScrollBar (), &QScrollBar::valueChanged,
+             this, &GroupListWidget::scheduleMaterialize);
+    connect (this, &QTreeWidget::itemExpanded,
+             this, &GroupListWidget::scheduleMaterialize);
+
     if ((m_ != NULL) && (m_->groupCount() > 0))
         recreateFromGroup ();
     GROUPLISTWIDGET_TRACE_EXIT;
@@ -282,12 +459,15 @@ void GroupListWidget::setUnderModel (GroupModel *model)
     GROUPLISTWIDGET_TRACE_ENTRY;
 
     if (model == NULL) {
-        GROUPLISTWIDGET_DEBUGM("Underlying model cannot be NULL\n");
+        GROUPLISTWIDGET_LOG_WARNING(
+                    grpLogView,
+                    "Underlying model cannot be NULL");
         return;
     }
     if (m_ == model) {
-        GROUPLISTWIDGET_DEBUGM("Attempt to install same model "
-                               "twice blocked.\n");
+        GROUPLISTWIDGET_LOG_WARNING(
+                    grpLogView,
+                    "Attempt to install same model twice blocked.");
         return;
     }
     uninstallUnderModel (true);
@@ -467,7 +647,8 @@ void GroupListWidget::setListDelegate (QAbstractItemDelegate *value)
         int i_max = topLevelItemCount();
         for (int i = 0; i < i_max; ++i) {
             GrpTreeItem * it = static_cast<GrpTreeItem *>(topLevelItem (i));
-            it->lv_->setItemDelegate (value);
+            if (it->lv_ != NULL)
+                it->lv_->setItemDelegate (value);
         }
         arangeLists ();
     }
@@ -505,6 +686,8 @@ void GroupListWidget::setViewMode (QListView::ViewMode value)
         int i_max = topLevelItemCount();
         for (int i = 0; i < i_max; ++i) {
             GrpTreeItem * it = static_cast<GrpTreeItem *>(topLevelItem (i));
+            if (it->lv_ == NULL)
+                continue;
             it->lv_->setViewMode (value);
             it->lv_->setWrapping (true);
         }
@@ -525,6 +708,8 @@ void GroupListWidget::setFlow (QListView::Flow value)
         int i_max = topLevelItemCount();
         for (int i = 0; i < i_max; ++i) {
             GrpTreeItem * it = static_cast<GrpTreeItem *>(topLevelItem (i));
+            if (it->lv_ == NULL)
+                continue;
             it->lv_->setFlow (value);
             it->lv_->setWrapping (true);
         }
@@ -533,6 +718,30 @@ void GroupListWidget::setFlow (QListView::Flow value)
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+/**
+ * When enabled, each embedded list paints its items into fixed-size
+ * tiles that are reused while scrolling and are only repainted when
+ * the items they show change. Hover effects are not shown in this mode.
+ *
+ * @param value true to enable the cache, false to paint directly
+ */
+void GroupListWidget::setTileCaching (bool value)
+{
+    if (tile_caching_ == value)
+        return;
+    tile_caching_ = value;
+    int i_max = topLevelItemCount();
+    for (int i = 0; i < i_max; ++i) {
+        GrpTreeItem * it = static_cast<GrpTreeItem *>(topLevelItem (i));
+        if (it->lv_ != NULL) {
+            it->lv_->clearTiles ();
+            it->lv_->viewport ()->update ();
+        }
+    }
+}
+/* ========================================================================= */
+
 /* ------------------------------------------------------------------------- */
 QSize GroupListWidget::gridCellFromDelegate (
         QAbstractItemDelegate * delegate, QStyleOptionViewItem & option) const
@@ -554,16 +763,34 @@ QSize GroupListWidget::computeGridCell () const
     QSize sz;
     int i_max = topLevelItemCount();
     if ((m_->baseModel() != NULL) && (i_max > 0)) {
-        // update lists currently visible
-        GrpTreeItem * it = static_cast<GrpTreeItem *>(topLevelItem (0));
-
-        if (list_delegate_ != NULL) {
-            QStyleOptionViewItem vopts = it->lv_->viewOptions ();
+        // in lazy mode not all groups have a list
+        GroupListGroup * lv = NULL;
+        for (int i = 0; (i < i_max) && (lv == NULL); ++i) {
+            lv = static_cast<GrpTreeItem *>(topLevelItem (i))->lv_;
+        }
+        GroupListDelegate * our_del =
+                qobject_cast<GroupListDelegate*>(list_delegate_);
+
+        if (our_del != NULL) {
+            sz = our_del->gridCell ();
+        } else if (lv == NULL) {
+            if (list_view_mode_ == QListView::ListMode) {
+                sz = QSize (2 + pixmap_size_ + 2 + pixmap_size_ + 2, 2 + pixmap_size_ + 2);
+            } else {
+                GroupFontGeometry fm = geometry_cache_->fontGeometry (
+                            font(), devicePixelRatio ());
+                sz = QSize (
+                            2 + pixmap_size_ + 2,
+                            2 + pixmap_size_ + 2 +
+                            static_cast<int>(fm.height_*1.2) + 2);
+            }
+        } else if (list_delegate_ != NULL) {
+            QStyleOptionViewItem vopts = lv->viewOptions ();
             sz = gridCellFromDelegate (list_delegate_, vopts);
         } else {
-            QAbstractItemDelegate * d = it->lv_->itemDelegate();
+            QAbstractItemDelegate * d = lv->itemDelegate();
             if (d != NULL) {
-                QStyleOptionViewItem vopts = it->lv_->viewOptions ();
+                QStyleOptionViewItem vopts = lv->viewOptions ();
                 sz = gridCellFromDelegate (d, vopts);
                 QSize autocmop;
                 if (list_view_mode_ == QListView::ListMode) {
@@ -571,12 +798,13 @@ QSize GroupListWidget::computeGridCell () const
                                 2 + pixmap_size_ + 2 + pixmap_size_ + 2,
                                 2 + pixmap_size_ + 2);
                 } else {
-                    QFontMetrics fm(font());
+                    GroupFontGeometry fm = geometry_cache_->fontGeometry (
+                            font(), devicePixelRatio ());
 
                     autocmop = QSize (
                                 2 + pixmap_size_ + 2,
                                 2 + pixmap_size_ + 2 +
-                                static_cast<int>(fm.height()*1.2) + 2);
+                                static_cast<int>(fm.height_*1.2) + 2);
                 }
                 sz = QSize (qMax (sz.width(), autocmop.width()),
                             qMax (sz.height(), autocmop.height()));
@@ -584,11 +812,12 @@ QSize GroupListWidget::computeGridCell () const
                 if (list_view_mode_ == QListView::ListMode) {
                     sz = QSize (2 + pixmap_size_ + 2 + pixmap_size_ + 2, 2 + pixmap_size_ + 2);
                 } else {
-                    QFontMetrics fm(font());
+                    GroupFontGeometry fm = geometry_cache_->fontGeometry (
+                            font(), devicePixelRatio ());
                     sz = QSize (
                                 2 + pixmap_size_ + 2,
                                 2 + pixmap_size_ + 2 +
-                                static_cast<int>(fm.height()*1.2) + 2);
+                                static_cast<int>(fm.height_*1.2) + 2);
                 }
             }
         }
@@ -625,7 +854,8 @@ void GroupListWidget::reinitDelegate ()
             GrpTreeItem * it = static_cast<GrpTreeItem *>(topLevelItem (i));
             //GroupSubModel * subm = static_cast<GroupSubModel *>(it->lv_->model());
             //subm->signalReset ();
-            it->lv_->setGridSize (sz);
+            if (it->lv_ != NULL)
+                it->lv_->setGridSize (sz);
         }
     }
 }
@@ -653,15 +883,26 @@ void GroupListWidget::appendToMenu (QMenu *menu)
 /* ------------------------------------------------------------------------- */
 void GroupListWidget::underModelAboutToBeReset()
 {
-    clear ();
+    // the groups are about to be destroyed but the items and their
+    // lists are kept, to be bound to the new groups; the old content
+    // stays on screen until the new one is ready
+    holdUpdates ();
+    populate_timer_->stop ();
+    captureState ();
+    int i_max = topLevelItemCount();
+    for (int i = 0; i < i_max; ++i) {
+        static_cast<GrpTreeItem *>(topLevelItem (i))->gsm_ = NULL;
+    }
 }
 /* ========================================================================= */
 
 /* ------------------------------------------------------------------------- */
 void GroupListWidget::underModelReset()
 {
+    GROUPLISTWIDGET_TRACE_SCOPE("GroupListWidget::underModelReset");
     grid_cell_ = computeGridCell ();
     reinitDelegate ();
+    followBaseModel ();
     recreateFromGroup ();
 }
 /* ========================================================================= */
@@ -673,11 +914,18 @@ void GroupListWidget::underGroupingChanged (int, Qt::SortOrder)
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+void GroupListWidget::underLabelsChanged ()
+{
+    refreshGeometry ();
+}
+/* ========================================================================= */
+
 /* ------------------------------------------------------------------------- */
 void GroupListWidget::listViewSelChange (
         const QModelIndex & current, const QModelIndex &)
 {
-    if (!current.isValid()) {
+    if (!current.isValid() || restoring_) {
         return;
     }
     const GroupSubModel * gsm =
@@ -687,17 +935,14 @@ void GroupListWidget::listViewSelChange (
         return;
     }
 
-    // make sure that only a single listview item is selected across all
-    // lists
-    int i_max = topLevelItemCount();
-    for (int i = 0; i < i_max; ++i) {
-        GrpTreeItem * iter = static_cast<GrpTreeItem *>(topLevelItem(i));
-        if (iter->gsm_ == gsm) {
-            // found the model that triggered the event
-        } else if (iter->lv_ != NULL){
-            iter->lv_->setCurrentIndex (QModelIndex());
-        }
+    // make sure that only a single listview has a current item;
+    // only the one that had it before needs to be told
+    GrpTreeItem * it = itemForGroup (gsm);
+    GroupListGroup * lv = it == NULL ? NULL : it->lv_;
+    if (!current_lv_.isNull () && (current_lv_ != lv)) {
+        current_lv_->setCurrentIndex (QModelIndex());
     }
+    current_lv_ = lv;
     int row_in_list = current.row();
     int prev_current = current_row_;
     current_row_ = gsm->mapRowToBaseModel (row_in_list);
@@ -707,29 +952,217 @@ void GroupListWidget::listViewSelChange (
 /* ========================================================================= */
 
 /* ------------------------------------------------------------------------- */
-void GroupListWidget::setBlueItem (int value)
+/**
+ * The lists read the selection from the shared one when they paint,
+ * so repainting the visible part of the tree is enough.
+ */
+void GroupListWidget::crossSelectionChange ()
 {
-    if ((value < 0) || (value >= m_->count ())) {
+    viewport ()->update ();
+}
+/* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+/**
+ * The selection is kept by row in base model, so the selected records
+ * keep their state when rows are inserted or removed before them.
+ */
+void GroupListWidget::followBaseModel ()
+{
+    QAbstractItemModel * base = m_ == NULL ? NULL : m_->baseModel ();
+    if (base == selection_base_.data ())
+        return;
+    if (!selection_base_.isNull ())
+        disconnect (selection_base_.data (), NULL, this, NULL);
+    selection_base_ = base;
+    selection_->clear ();
+    if (base == NULL)
+        return;
+
+    connect (base, &QAbstractItemModel::rowsInserted,
+             this, &GroupListWidget::baseRowsInserted);
+    connect (base, &QAbstractItemModel::rowsRemoved,
+             this, &GroupListWidget::baseRowsRemoved);
+    connect (base, &QAbstractItemModel::rowsMoved,
+             this, &GroupListWidget::baseRowsRearranged);
+    connect (base, &QAbstractItemModel::layoutChanged,
+             this, &GroupListWidget::baseRowsRearranged);
+    connect (base, &QAbstractItemModel::modelReset,
+             this, &GroupListWidget::baseRowsRearranged);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListWidget::baseRowsInserted (
+        const QModelIndex & parent, int first, int last)
+{
+    if (!parent.isValid ())
+        selection_->insertRows (first, last - first + 1);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListWidget::baseRowsRemoved (
+        const QModelIndex & parent, int first, int last)
+{
+    if (!parent.isValid ())
+        selection_->removeRows (first, last - first + 1);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The records can not be followed through a move or a new layout,
+ * so the selection is dropped.
+ */
+void GroupListWidget::baseRowsRearranged ()
+{
+    selection_->clear ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * With a mode other than QAbstractItemView::SingleSelection the user
+ * can select items in more than one group; the result is available
+ * in selection().
+ */
+void GroupListWidget::setListSelectionMode (
+        QAbstractItemView::SelectionMode value)
+{
+    list_selection_mode_ = value;
+    int i_max = topLevelItemCount();
+    for (int i = 0; i < i_max; ++i) {
+        GrpTreeItem * iter = static_cast<GrpTreeItem *>(topLevelItem(i));
+        if (iter->lv_ != NULL)
+            iter->lv_->setSelectionMode (value);
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The group and the position inside it are found in constant time.
+ * The group is expanded and gets a list if it has none (lazy and
+ * progressive modes) and the widget is scrolled so that the item
+ * is visible. The position of the item is computed from the grid, so
+ * the list does not need to be laid out; a list created here is sized
+ * from the grid and arranged at next iteration of event loop.
+ *
+ * The change is reported through currentLVItemChanged() as if the
+ * user clicked the item.
+ *
+ * @param value the row in base model; -1 (or any other row outside
+ *              valid range) clears current item
+ */
+void GroupListWidget::setBlueItem (int value)
+{
+    for (;;) {
+        if ((value < 0) || (value >= m_->count ()))
+            break;
+        int index_in_group = -1;
+        GroupSubModel * subgrp = m_->groupForRow (value, &index_in_group);
+        if (subgrp == NULL)
+            break;
+        GrpTreeItem * it = itemForGroup (subgrp);
+        if (it == NULL)
+            break;
 
+        if (!it->isExpanded ())
+            it->setExpanded (true);
+        if (!ensureListView (it, true))
+            break;
 
-        /// @todo deselect
-        ///
-        ///
-        ///
+        GroupListGroup * lv = it->lv_;
+        lv->setCurrentIndex (subgrp->index (index_in_group, 0));
+
+        // where the item is relative to the top of the tree
+        QTreeWidgetItem * host = it->childCount() > 0 ? it->child (0) : it;
+        QScrollBar * sb = verticalScrollBar ();
+        QSize cell = gridCell ();
+        int item_top = sb->value () + visualItemRect (host).top () +
+                lv->frameWidth () + itemOffset (index_in_group, lv->height (), host);
+
+        // only scroll if the item is not entirely visible
+        int vp_height = viewport ()->height ();
+        if ((item_top < sb->value ()) ||
+                (item_top + cell.height () > sb->value () + vp_height)) {
+            sb->setValue (item_top - (vp_height - cell.height ()) / 2);
+        }
         return;
-    } else {
-        int index_in_group;
-        GroupSubModel * subgrp = m_->groupForRow (
-                    value, &index_in_group);
+    }
 
-        /// @todo
-        ///
-        ///
-        ///
+    // clear current item
+    if (!current_lv_.isNull ()) {
+        current_lv_->setCurrentIndex (QModelIndex());
+        current_lv_ = NULL;
+        selection_->clear ();
+    }
+    int prev_current = current_row_;
+    current_row_ = -1;
+    if (prev_current != -1) {
+        emit currentLVItemChanged (-1, prev_current);
+        emit currentLVItemChangedEx (-1, -1, -1);
+    }
+}
+/* ========================================================================= */
 
-        current_row_ = value;
+/* ------------------------------------------------------------------------- */
+/**
+ * The items in a list are placed on a uniform grid, so the position
+ * only depends on the index and on the number of items in a line
+ * (left to right flow) or in a column (top to bottom flow).
+ */
+int GroupListWidget::itemOffset (
+        int index_in_group, int list_height, const QTreeWidgetItem * host)
+{
+    QSize cell = gridCell ();
+    if (!cell.isValid() || cell.isEmpty())
+        return 0;
+    int line;
+    if (list_flow_ == QListView::LeftToRight) {
+        line = index_in_group / itemsPerLine (cell, host);
+    } else {
+        int per_column = qMax (
+                    1, (list_height - listFrameWidth () * 2) / cell.height());
+        line = index_in_group % per_column;
     }
+    return line * cell.height();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The lists are hosted by the child rows when grouping and by the
+ * top-level row otherwise; a list starts after the indentation of the
+ * levels above its host (plus the one taken by the decoration of the
+ * root) and takes the rest of the viewport.
+ */
+int GroupListWidget::listWidth (const QTreeWidgetItem * host) const
+{
+    int levels = rootIsDecorated () ? 1 : 0;
+    for (const QTreeWidgetItem * p = host->parent (); p != NULL;
+         p = p->parent ()) {
+        ++levels;
+    }
+    return qMax (1, viewport ()->width () - indentation () * levels);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int GroupListWidget::listFrameWidth () const
+{
+    return style ()->pixelMetric (QStyle::PM_DefaultFrameWidth, NULL, this);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int GroupListWidget::itemsPerLine (
+        const QSize & cell, const QTreeWidgetItem * host) const
+{
+    if (!cell.isValid() || cell.isEmpty())
+        return 1;
+    return qMax (1, (listWidth (host) - listFrameWidth () * 2) / cell.width());
 }
 /* ========================================================================= */
 
@@ -789,6 +1222,8 @@ void GroupListWidget::resizeEvent (QResizeEvent *e)
     resize_guard_ = true;
 
     arangeLists ();
+    scheduleMaterialize ();
+    placeOverlay ();
 
     e->accept();
     resize_guard_ = false;
@@ -815,40 +1250,709 @@ void GroupListWidget::wheelEvent (QWheelEvent * event)
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+void GroupListWidget::changeEvent (QEvent * event)
+{
+    QTreeWidget::changeEvent (event);
+    switch (event->type ()) {
+    case QEvent::FontChange:
+        invalidateHeaderCache ();
+        refreshGeometry ();
+        break;
+    case QEvent::PaletteChange:
+    case QEvent::StyleChange:
+        invalidateHeaderCache ();
+        break;
+    default:
+        break;
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The tree paints the group headers; the items are painted by the lists
+ * in their own paint events.
+ */
+void GroupListWidget::paintEvent (QPaintEvent * event)
+{
+    GroupFrameStats * stats = frameStats ();
+    if (stats == NULL) {
+        QTreeWidget::paintEvent (event);
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start ();
+    QTreeWidget::paintEvent (event);
+    stats->addPaintNs (timer.nsecsElapsed ());
+    stats->add (GroupFrameStats::CounterPaintEvents);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The headers are cached in QPixmapCache under a key that includes
+ * a generation number; changing the number makes the old pixmaps
+ * unreachable and they are evicted by QPixmapCache in time.
+ */
+void GroupListWidget::invalidateHeaderCache ()
+{
+    ++header_generation_;
+    viewport ()->update ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The geometry cache is usually shared with other widgets and is
+ * accounted in full. Headers are counted for every group that is not
+ * hidden, whether or not QPixmapCache still holds its pixmap.
+ */
+GroupMemoryUsage GroupListWidget::memoryUsage () const
+{
+    GroupMemoryUsage result;
+    if (m_ != NULL)
+        result = m_->memoryUsage ();
+
+    foreach (GroupListGroup * lv, findChildren<GroupListGroup*> ()) {
+        result.add (GroupMemoryUsage::PartViews, sizeof (GroupListGroup));
+        result.add (GroupMemoryUsage::PartTiles,
+                    lv->tileBytes (), lv->tileCount ());
+    }
+
+    GroupListDelegate * deleg = qobject_cast<GroupListDelegate*> (list_delegate_);
+    if (deleg != NULL)
+        deleg->addMemoryUsage (&result);
+
+    if (geometry_cache_ != NULL)
+        geometry_cache_->addMemoryUsage (&result);
+
+    // only the headers that are still in QPixmapCache count
+    int i_max = topLevelItemCount ();
+    for (int i = 0; i < i_max; ++i) {
+        GrpTreeItem * it = static_cast<GrpTreeItem *>(topLevelItem (i));
+        QPixmap pm;
+        if (QPixmapCache::find (it->header_key_, &pm)) {
+            result.add (GroupMemoryUsage::PartHeaders,
+                        GroupMemoryUsage::pixmapBytes (pm));
+        }
+    }
+
+    if (selection_ != NULL) {
+        result.add (GroupMemoryUsage::PartSelection,
+                    GroupMemoryUsage::vectorBytes (
+                        (selection_->rowCount () + 7) / 8, 1),
+                    selection_->count ());
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * In diagnostics mode the widget measures the time spent in paint
+ * events and in arangeLists(), counts the headers and items that are
+ * painted and the requests served by the caches. The figures are
+ * collected until the control returns to the event loop, then they
+ * are published through frameMeasured() and lastFrameStats().
+ */
+void GroupListWidget::setDiagnostics (bool value)
+{
+    if (value == diagnostics_)
+        return;
+    diagnostics_ = value;
+    frame_open_ = false;
+    frame_timer_->stop ();
+    if (!value)
+        setDiagnosticsOverlay (false);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The overlay is a label placed over the top right corner of the
+ * viewport and is refreshed at most four times a second. Showing the
+ * overlay turns on the diagnostics mode.
+ */
+void GroupListWidget::setDiagnosticsOverlay (bool value)
+{
+    if (value == (overlay_ != NULL))
+        return;
+    if (value) {
+        setDiagnostics (true);
+        overlay_ = new QLabel (this);
+        overlay_->setAttribute (Qt::WA_TransparentForMouseEvents);
+        overlay_->setFocusPolicy (Qt::NoFocus);
+        // an opaque label does not force the lists below it to repaint,
+        // which would start a new frame each time the label changes
+        overlay_->setAutoFillBackground (true);
+        overlay_->setBackgroundRole (QPalette::ToolTipBase);
+        overlay_->setForegroundRole (QPalette::ToolTipText);
+        overlay_->setMargin (4);
+        overlay_->show ();
+        updateOverlay ();
+    } else {
+        overlay_timer_->stop ();
+        delete overlay_;
+        overlay_ = NULL;
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The first call after the control returned to the event loop starts
+ * a new frame and schedules its end.
+ */
+GroupFrameStats * GroupListWidget::frameStats ()
+{
+    if (!diagnostics_)
+        return NULL;
+    if (!frame_open_) {
+        frame_open_ = true;
+        frame_.clear ();
+        frame_.setFrame (++frame_count_);
+        sampleCaches (&frame_base_);
+        frame_timer_->start ();
+    }
+    return &frame_;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListWidget::sampleCaches (GroupFrameStats * stats) const
+{
+    stats->clear ();
+    GroupListDelegate * deleg = qobject_cast<GroupListDelegate*> (list_delegate_);
+    if (deleg != NULL) {
+        stats->add (GroupFrameStats::CounterTextHits, deleg->textCacheHits ());
+        stats->add (GroupFrameStats::CounterTextMisses, deleg->textCacheMisses ());
+        const GroupPixmapPyramid & pyramid = deleg->pixmapPyramid ();
+        stats->add (GroupFrameStats::CounterPixmapHits, pyramid.hits ());
+        stats->add (GroupFrameStats::CounterPixmapMisses, pyramid.misses ());
+    }
+    if (geometry_cache_ != NULL) {
+        stats->add (GroupFrameStats::CounterGeometryHits, geometry_cache_->hits ());
+        stats->add (GroupFrameStats::CounterGeometryMisses, geometry_cache_->misses ());
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListWidget::endFrame ()
+{
+    if (!frame_open_)
+        return;
+    frame_open_ = false;
+
+    static const GroupFrameStats::Counter sampled[] = {
+        GroupFrameStats::CounterTextHits,
+        GroupFrameStats::CounterTextMisses,
+        GroupFrameStats::CounterPixmapHits,
+        GroupFrameStats::CounterPixmapMisses,
+        GroupFrameStats::CounterGeometryHits,
+        GroupFrameStats::CounterGeometryMisses
+    };
+    GroupFrameStats now;
+    sampleCaches (&now);
+    for (unsigned i = 0; i < sizeof (sampled) / sizeof (sampled[0]); ++i) {
+        // the counters start again from zero when a cache is replaced
+        GroupFrameStats::Counter c = sampled[i];
+        frame_.add (c, qMax (Q_INT64_C(0), now.value (c) - frame_base_.value (c)));
+    }
+
+    last_frame_ = frame_;
+    GROUPLISTWIDGET_LOG_DEBUG(
+                grpLogView,
+                "frame %d: paint %lld ns, arrange %lld ns",
+                last_frame_.frame (), last_frame_.paintNs (),
+                last_frame_.arrangeNs ());
+    if ((overlay_ != NULL) && !overlay_timer_->isActive ())
+        overlay_timer_->start ();
+    emit frameMeasured (last_frame_);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListWidget::updateOverlay ()
+{
+    if (overlay_ == NULL)
+        return;
+    QString text = last_frame_.toString ().trimmed ();
+    if (text.isEmpty () || (last_frame_.frame () == 0))
+        text = tr ("no frame measured yet");
+    overlay_->setText (text);
+    placeOverlay ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListWidget::placeOverlay ()
+{
+    if (overlay_ == NULL)
+        return;
+    overlay_->adjustSize ();
+    QRect vp = viewport ()->geometry ();
+    overlay_->move (vp.right () - overlay_->width () - 4, vp.top () + 4);
+    overlay_->raise ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The cache is not owned by the widget and must outlive it.
+ */
+void GroupListWidget::setGeometryCache (GroupGeometryCache * value)
+{
+    if (value == NULL)
+        value = GroupGeometryCache::global ();
+    if (value == geometry_cache_)
+        return;
+    geometry_cache_ = value;
+    refreshGeometry ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListWidget::refreshGeometry ()
+{
+    reinitDelegate ();
+    grid_cell_ = computeGridCell ();
+    arangeLists ();
+}
+/* ========================================================================= */
+
 /* ------------------------------------------------------------------------- */
 void GroupListWidget::arangeLists ()
 {
+    GROUPLISTWIDGET_TRACE_SCOPE("GroupListWidget::arangeLists");
+    GroupFrameStats * stats = frameStats ();
+    QElapsedTimer timer;
+    if (stats != NULL)
+        timer.start ();
+
     int i_max = topLevelItemCount();
+    bool b_estimate = (lazy_views_ && canEstimateGroups ()) || isPopulating ();
     for (int i = 0; i < i_max; ++i) {
-        // get the visual rectangle of the last item
         GrpTreeItem * it = static_cast<GrpTreeItem *>(topLevelItem (i));
-        GroupListGroup * lv = it->lv_;
-        GroupSubModel * gsm = it->gsm_;
-        if ((lv != NULL) && (gsm != NULL)) {
-            for (int j = 0; j < 2; ++j) {
-                lv->doItemsLayout();
-                QRect r = lv->visualRect (
-                            gsm->index (gsm->rowCount() - 1, 0));
-                int addf = lv->frameWidth() * 2 + 4;
-                int this_width = size().width();
-                int new_width = this_width - lv->pos().x();
-                if (new_width < r.width() + 2)
-                    new_width = r.width() + 2;
-                QSize new_size (new_width, r.bottom() + addf);
-
-                lv->setMinimumSize (new_size);
-                lv->setMaximumSize (new_size);
-                lv->resize (new_size);
-                lv->setSizePolicy (QSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed));
-                if (it->childCount() > 0) {
-                    it->child (0)->setSizeHint (0, new_size);
-                } else {
-                    it->setSizeHint (0, new_size);
-                }
-            }
+        if (it->lv_ != NULL) {
+            arangeList (it);
+        } else if (b_estimate && (it->gsm_ != NULL) && (it->childCount() > 0)) {
+            // groups without a list use the size computed from the grid
+            it->child (0)->setSizeHint (
+                        0, estimateGroupSize (it->gsm_, it->child (0)));
         }
     }
     scheduleDelayedItemsLayout ();
+
+    if (stats != NULL) {
+        stats->addArrangeNs (timer.nsecsElapsed ());
+        stats->add (GroupFrameStats::CounterArrangeCalls);
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListWidget::arangeList (GrpTreeItem * it)
+{
+    // get the visual rectangle of the last item
+    GroupListGroup * lv = it->lv_;
+    GroupSubModel * gsm = it->gsm_;
+    QTreeWidgetItem * host = it->childCount() > 0 ? it->child (0) : it;
+    if ((lv != NULL) && (gsm != NULL)) {
+        for (int j = 0; j < 2; ++j) {
+            lv->doItemsLayout();
+            QRect r = lv->visualRect (
+                        gsm->index (gsm->rowCount() - 1, 0));
+            int addf = lv->frameWidth() * 2 + 4;
+            int new_width = listWidth (host);
+            if (new_width < r.width() + 2)
+                new_width = r.width() + 2;
+            QSize new_size (new_width, r.bottom() + addf);
+
+            lv->setMinimumSize (new_size);
+            lv->setMaximumSize (new_size);
+            lv->resize (new_size);
+            lv->setSizePolicy (QSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed));
+            host->setSizeHint (0, new_size);
+        }
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The size can only be computed when all the items share the same cell
+ * of a grid, which is the case when the delegate is a GroupListDelegate or
+ * when the pixmap size is set.
+ */
+bool GroupListWidget::canEstimateGroups () const
+{
+    if (qobject_cast<GroupListDelegate*>(list_delegate_) != NULL)
+        return true;
+    return pixmap_size_ != -1;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * This mirrors the computation in arangeList() but uses the grid
+ * instead of the geometry of a list, so it can be used for groups that
+ * don't have a list.
+ */
+QSize GroupListWidget::estimateGroupSize (
+        GroupSubModel * gsm, const QTreeWidgetItem * host)
+{
+    QSize cell;
+    GroupListDelegate * our_del =
+            qobject_cast<GroupListDelegate*>(list_delegate_);
+    if (our_del != NULL) {
+        cell = our_del->gridCell ();
+    } else {
+        cell = gridCell ();
+    }
+    int new_width = listWidth (host);
+    if (!cell.isValid() || cell.isEmpty())
+        return QSize (new_width, 4);
+
+    int per_line = itemsPerLine (cell, host);
+    int lines = (gsm->rowCount() + per_line - 1) / per_line;
+    return QSize (new_width, lines * cell.height() + listFrameWidth () * 2 + 3);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * In lazy mode only the groups that are expanded and visible (or
+ * about to become visible) have a list. Other groups are represented
+ * by an empty item that has the size of the list.
+ *
+ * The lists that are not visible for lazyReleaseDelay() milliseconds
+ * are released. The list that hosts current item is never released.
+ *
+ * @param value true to enable the lazy mode.
+ */
+void GroupListWidget::setLazyViews (bool value)
+{
+    if (lazy_views_ == value)
+        return;
+    lazy_views_ = value;
+    if (lazy_views_) {
+        release_timer_->start (qMax (lazy_release_ms_ / 2, 100));
+    } else {
+        release_timer_->stop ();
+    }
+    recreateFromGroup ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListWidget::setLazyReleaseDelay (int value)
+{
+    lazy_release_ms_ = value;
+    if (lazy_views_) {
+        release_timer_->start (qMax (lazy_release_ms_ / 2, 100));
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * In progressive mode the groups that are visible get their lists
+ * right away and the rest are created in slices from the event loop,
+ * each slice taking about sliceBudget() milliseconds. Until then
+ * the groups have the size computed from the grid. If the size of
+ * the items is not known (no GroupListDelegate and no pixmap size) all
+ * lists are created right away, as in the default mode.
+ *
+ * The lazy mode takes precedence over this one.
+ *
+ * @param value true to enable the progressive mode.
+ */
+void GroupListWidget::setProgressive (bool value)
+{
+    if (progressive_ == value)
+        return;
+    progressive_ = value;
+    if (!progressive_ && isPopulating ()) {
+        // create remaining lists now
+        populate_timer_->stop ();
+        recreateFromGroup ();
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool GroupListWidget::isPopulating () const
+{
+    return populate_timer_->isActive ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListWidget::populateSlice ()
+{
+    GROUPLISTWIDGET_TRACE_SCOPE("GroupListWidget::populateSlice");
+    QElapsedTimer slice;
+    slice.start ();
+    bool b_created = false;
+    int i_max = topLevelItemCount();
+    while (populate_next_ < i_max) {
+        GrpTreeItem * it = static_cast<GrpTreeItem *>(
+                    topLevelItem (populate_next_));
+        ++populate_next_;
+        if (it->lv_ == NULL)
+            b_created |= ensureListView (it);
+        if (slice.elapsed () >= slice_budget_ms_)
+            break;
+    }
+
+    if (populate_next_ >= i_max)
+        populate_timer_->stop ();
+    if (b_created)
+        scheduleDelayedItemsLayout ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * A list that is created with @p b_defer gets the size computed from
+ * the grid (if that can be computed) and is laid out at next iteration
+ * of event loop.
+ *
+ * @return true if the item has a list at the end
+ */
+bool GroupListWidget::ensureListView (GrpTreeItem * it, bool b_defer)
+{
+    if ((it->lv_ == NULL) && (it->gsm_ != NULL) && (it->childCount() > 0)) {
+        it->lv_ = createListView (it->gsm_, it->child (0));
+        if (b_defer && canEstimateGroups ()) {
+            QSize new_size = estimateGroupSize (it->gsm_, it->child (0));
+            it->lv_->setMinimumSize (new_size);
+            it->lv_->setMaximumSize (new_size);
+            it->lv_->resize (new_size);
+            it->child (0)->setSizeHint (0, new_size);
+            arrange_pending_.append (it->lv_);
+            arrange_timer_->start ();
+        } else {
+            arangeList (it);
+        }
+    }
+    return it->lv_ != NULL;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListWidget::arangePending ()
+{
+    QList<QPointer<GroupListGroup> > pending = arrange_pending_;
+    arrange_pending_.clear ();
+    foreach (const QPointer<GroupListGroup> & lv, pending) {
+        if (lv.isNull ())
+            continue;
+        GroupSubModel * gsm = qobject_cast<GroupSubModel *>(lv->model ());
+        GrpTreeItem * it = gsm == NULL ? NULL : itemForGroup (gsm);
+        if ((it != NULL) && (it->lv_ == lv.data ()))
+            arangeList (it);
+    }
+    scheduleDelayedItemsLayout ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The position inside the model is checked first so the lookup
+ * usually takes constant time.
+ */
+GrpTreeItem * GroupListWidget::itemForGroup (const GroupSubModel * gsm) const
+{
+    int i = gsm->listIndex ();
+    int i_max = topLevelItemCount();
+    if ((i >= 0) && (i < i_max)) {
+        GrpTreeItem * it = static_cast<GrpTreeItem *>(topLevelItem (i));
+        if (it->gsm_ == gsm)
+            return it;
+    }
+    for (i = 0; i < i_max; ++i) {
+        GrpTreeItem * it = static_cast<GrpTreeItem *>(topLevelItem (i));
+        if (it->gsm_ == gsm)
+            return it;
+    }
+    return NULL;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Only the information stored in the items is used (the groups may be
+ * gone by now): the keys of collapsed groups, the group at the top of
+ * the viewport and the current row. Calls after the first one
+ * do nothing until the state is restored.
+ */
+void GroupListWidget::captureState ()
+{
+    if (state_saved_)
+        return;
+    state_saved_ = true;
+    saved_row_ = current_row_;
+    collapsed_keys_.clear ();
+    anchor_key_.clear ();
+    anchor_offset_ = 0;
+
+    int i_max = topLevelItemCount();
+    for (int i = 0; i < i_max; ++i) {
+        GrpTreeItem * it = static_cast<GrpTreeItem *>(topLevelItem (i));
+        if (it->isHidden () || (it->childCount() == 0))
+            continue;
+        if (!it->isExpanded ())
+            collapsed_keys_.insert (it->key_);
+    }
+
+    QTreeWidgetItem * top = itemAt (QPoint (0, 0));
+    if (top != NULL) {
+        if (top->parent () != NULL)
+            top = top->parent ();
+        anchor_key_ = static_cast<GrpTreeItem *>(top)->key_;
+        anchor_offset_ = -visualItemRect (top).top ();
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The expanded state is applied while the items are created; this
+ * selects the item that was current and scrolls the group that was at
+ * the top back in place. No signal is emitted here.
+ */
+void GroupListWidget::restoreState ()
+{
+    if (!state_saved_)
+        return;
+    state_saved_ = false;
+    current_row_ = -1;
+    current_lv_ = NULL;
+
+    if ((saved_row_ >= 0) && (saved_row_ < m_->count ())) {
+        int index_in_group = -1;
+        GroupSubModel * gsm = m_->groupForRow (saved_row_, &index_in_group);
+        GrpTreeItem * it = gsm == NULL ? NULL : itemForGroup (gsm);
+        if ((it != NULL) && ensureListView (it)) {
+            restoring_ = true;
+            it->lv_->setCurrentIndex (gsm->index (index_in_group, 0));
+            restoring_ = false;
+            current_row_ = saved_row_;
+            current_lv_ = it->lv_;
+        }
+    }
+
+    if (!anchor_key_.isEmpty ()) {
+        int i_max = topLevelItemCount();
+        for (int i = 0; i < i_max; ++i) {
+            GrpTreeItem * it = static_cast<GrpTreeItem *>(topLevelItem (i));
+            if (it->isHidden () || (it->key_ != anchor_key_))
+                continue;
+            QScrollBar * sb = verticalScrollBar ();
+            sb->setValue (sb->value () + visualItemRect (it).top () +
+                          anchor_offset_);
+            break;
+        }
+    }
+
+    collapsed_keys_.clear ();
+    anchor_key_.clear ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Used when the model is replaced, as the state of the old one
+ * does not apply to the new one.
+ */
+void GroupListWidget::discardState ()
+{
+    state_saved_ = true;
+    saved_row_ = -1;
+    collapsed_keys_.clear ();
+    anchor_key_.clear ();
+    anchor_offset_ = 0;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListWidget::scheduleMaterialize ()
+{
+    if (lazy_views_ || isPopulating ()) {
+        materialize_timer_->start ();
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Walks the items from the top of the viewport down to half a screen
+ * below its bottom, so the cost only depends on what is visible.
+ */
+void GroupListWidget::materializeVisible ()
+{
+    GROUPLISTWIDGET_TRACE_SCOPE("GroupListWidget::materializeVisible");
+    if (!lazy_views_ && !isPopulating ())
+        return;
+
+    QRect vp = viewport ()->rect ();
+    int limit = vp.bottom () + vp.height () / 2;
+    qint64 now = clock_.elapsed ();
+    bool b_created = false;
+
+    QTreeWidgetItem * item = itemAt (vp.topLeft ());
+    while (item != NULL) {
+        if (visualItemRect (item).top () > limit)
+            break;
+        // only the row holding the list counts; a collapsed header does not
+        if (item->parent () != NULL) {
+            GrpTreeItem * grp = static_cast<GrpTreeItem *>(item->parent ());
+            grp->last_seen_ = now;
+            if (grp->lv_ == NULL)
+                b_created |= ensureListView (grp);
+        }
+        item = itemBelow (item);
+    }
+
+    if (b_created)
+        scheduleDelayedItemsLayout ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupListWidget::releaseHidden ()
+{
+    if (!lazy_views_)
+        return;
+    QRect vp = viewport ()->rect ();
+    qint64 now = clock_.elapsed ();
+    int i_max = topLevelItemCount();
+    for (int i = 0; i < i_max; ++i) {
+        GrpTreeItem * it = static_cast<GrpTreeItem *>(topLevelItem (i));
+        if ((it->lv_ == NULL) || (it->childCount() == 0) || it->isHidden ())
+            continue;
+
+        // the lists on screen are seen even if the user did not scroll
+        QTreeWidgetItem * sub = it->child (0);
+        if (visualItemRect (sub).intersects (vp)) {
+            it->last_seen_ = now;
+            continue;
+        }
+        if (now - it->last_seen_ < lazy_release_ms_)
+            continue;
+        if (it->lv_->currentIndex ().isValid ())
+            continue;
+
+        // the item keeps the size of the list
+        QSize sz = sub->sizeHint (0);
+        removeItemWidget (sub, 0);
+        it->lv_ = NULL;
+        sub->setSizeHint (0, sz);
+    }
 }
 /* ========================================================================= */
 
@@ -859,9 +1963,7 @@ GroupListGroup * GroupListWidget::createListView (
     GROUPLISTWIDGET_TRACE_ENTRY;
     GroupListGroup * lv = new GroupListGroup (this);
     if (smdl != NULL) {
-        lv->setModel (smdl);
-        connect(lv->selectionModel(), &QItemSelectionModel::currentChanged,
-                this, &GroupListWidget::listViewSelChange);
+        bindListView (lv, smdl);
     } else {
         Q_ASSERT(false);
     }
@@ -878,41 +1980,194 @@ GroupListGroup * GroupListWidget::createListView (
 }
 /* ------------------------------------------------------------------------- */
 
+/* ------------------------------------------------------------------------- */
+/**
+ * While updates are held the widget is not repainted, so the last
+ * frame stays visible. Calls do not nest; the first one wins.
+ */
+void GroupListWidget::holdUpdates ()
+{
+    if (updates_held_)
+        return;
+    updates_held_ = true;
+    updates_were_enabled_ = updatesEnabled ();
+    setUpdatesEnabled (false);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Enabling the updates schedules a single repaint of the widget.
+ */
+void GroupListWidget::releaseUpdates ()
+{
+    if (!updates_held_)
+        return;
+    updates_held_ = false;
+    setUpdatesEnabled (updates_were_enabled_);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The list may be a new one or one that was used for another group.
+ * QAbstractItemView::setModel() creates a selection model that is
+ * replaced right away by one that stores the selection in the shared
+ * GroupSelection, so binding a list costs nothing for the selection.
+ */
+void GroupListWidget::bindListView (
+        GroupListGroup * lv, GroupSubModel * smdl)
+{
+    if (lv->model () != smdl) {
+        QItemSelectionModel * prev = lv->selectionModel ();
+        lv->setModel (smdl);
+        QItemSelectionModel * created = lv->selectionModel ();
+        lv->setSelectionModel (new GroupSelectionModel (smdl, selection_, lv));
+        if (created != prev)
+            delete created;
+        delete prev;
+    }
+    connect(lv->selectionModel(), &QItemSelectionModel::currentChanged,
+            this, &GroupListWidget::listViewSelChange, Qt::UniqueConnection);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Items past \b used are hidden and kept, along with their lists, to be
+ * reused by next rebuild. Only viewPoolSize() such items are kept.
+ */
+void GroupListWidget::recycleSurplus (int used)
+{
+    int i_max = topLevelItemCount();
+    while (i_max > used + view_pool_size_) {
+        --i_max;
+        delete takeTopLevelItem (i_max);
+    }
+    for (int i = used; i < i_max; ++i) {
+        GrpTreeItem * it = static_cast<GrpTreeItem *>(topLevelItem (i));
+        it->gsm_ = NULL;
+        it->setHidden (true);
+    }
+}
+/* ========================================================================= */
+
 /* ========================================================================= */
+/**
+ * Existing items are reused (and their lists are bound to the new groups)
+ * as long as they are of the same kind: a header with a child hosting the
+ * list when grouping, a single item hosting the list otherwise.
+ */
 void GroupListWidget::recreateFromGroup ()
 {
+    GROUPLISTWIDGET_TRACE_SCOPE("GroupListWidget::recreateFromGroup");
     GROUPLISTWIDGET_TRACE_ENTRY;
-    clear ();
+    GROUPLISTWIDGET_STATS_PHASE(m_, PhaseRebuild);
+    holdUpdates ();
+    populate_timer_->stop ();
+    captureState ();
+    selection_->resize (m_->count ());
+    int prev_current = current_row_;
     int i_max = m_->groupCount ();
+    bool b_lazy = false;
+    bool b_progressive = false;
     for (;;) {
+        bool b_items_grouped =
+                (topLevelItemCount() > 0) &&
+                (topLevelItem (0)->childCount() > 0);
         if (m_->isGrouping()) {
-            for (int i = 0; i < i_max; ++i) {
+            if ((topLevelItemCount() > 0) && !b_items_grouped)
+                clear ();
+            // in lazy mode the lists are only created for visible groups,
+            // in progressive mode the visible ones are created first
+            b_lazy = lazy_views_ && canEstimateGroups ();
+            b_progressive = progressive_ && !lazy_views_ && canEstimateGroups ();
+
+            // new items are inserted in one go
+            int i_reused = qMin (i_max, topLevelItemCount());
+            QList<QTreeWidgetItem *> fresh;
+            for (int i = i_reused; i < i_max; ++i) {
                 GroupSubModel * gsm = m_->group (i);
                 GrpTreeItem * tvi = new GrpTreeItem (gsm->label(), i, gsm);
-                addTopLevelItem (tvi);
-                QTreeWidgetItem * subtvi = new QTreeWidgetItem (tvi);
-                tvi->lv_ = createListView (gsm, subtvi);
-                tvi->setExpanded (true);
+                tvi->key_ = groupStateKey (gsm);
+                new QTreeWidgetItem (tvi);
+                fresh.append (tvi);
+            }
+            addTopLevelItems (fresh);
+
+            // widgets can only be set once the items are in the tree
+            for (int i = 0; i < i_max; ++i) {
+                GroupSubModel * gsm = m_->group (i);
+                GrpTreeItem * tvi = static_cast<GrpTreeItem *>(topLevelItem (i));
+                if (i < i_reused) {
+                    tvi->setText (0, gsm->label());
+                    tvi->group_index_ = i;
+                    tvi->gsm_ = gsm;
+                    tvi->key_ = groupStateKey (gsm);
+                    tvi->setHidden (false);
+                }
+                QTreeWidgetItem * subtvi = tvi->child (0);
+                if (tvi->lv_ != NULL) {
+                    bindListView (tvi->lv_, gsm);
+                } else if (b_lazy || b_progressive) {
+                    subtvi->setSizeHint (0, estimateGroupSize (gsm, subtvi));
+                } else {
+                    tvi->lv_ = createListView (gsm, subtvi);
+                }
+                tvi->setExpanded (!collapsed_keys_.contains (tvi->key_));
             }
         } else {
             GroupSubModel * gsm = NULL;
             if (i_max == 1) {
                 gsm = m_->group (0);
             } else {
+                clear ();
                 break;
             }
-            GrpTreeItem * tvi = new GrpTreeItem (QString("test"), 0, gsm);
-            addTopLevelItem (tvi);
-            tvi->lv_ = createListView (gsm, tvi);
+            if (b_items_grouped)
+                clear ();
+            GrpTreeItem * tvi;
+            if (topLevelItemCount() > 0) {
+                tvi = static_cast<GrpTreeItem *>(topLevelItem (0));
+                tvi->gsm_ = gsm;
+                tvi->key_ = groupStateKey (gsm);
+                tvi->setHidden (false);
+                bindListView (tvi->lv_, gsm);
+            } else {
+                tvi = new GrpTreeItem (QString("test"), 0, gsm);
+                tvi->key_ = groupStateKey (gsm);
+                addTopLevelItem (tvi);
+                tvi->lv_ = createListView (gsm, tvi);
+            }
             tvi->setExpanded (true);
+            i_max = 1;
+        }
+        recycleSurplus (i_max);
+        if (b_progressive) {
+            populate_next_ = 0;
+            populate_timer_->start ();
         }
         arangeLists ();
+        if (b_lazy || b_progressive)
+            materializeVisible ();
         break;
     }
-
-    emit currentLVItemChanged (-1, -1);
-    emit currentLVItemChangedEx (-1, -1, -1);
-    current_row_ = -1;
+    restoreState ();
+    releaseUpdates ();
+
+    // a single notification for the final current item; its position
+    // in the groups is reported even if the row is the same
+    int index_in_group = -1;
+    GroupSubModel * gsm = current_row_ == -1 ? NULL :
+            m_->groupForRow (current_row_, &index_in_group);
+    if (current_row_ != prev_current)
+        emit currentLVItemChanged (current_row_, prev_current);
+    if (gsm == NULL) {
+        emit currentLVItemChangedEx (-1, -1, -1);
+    } else {
+        emit currentLVItemChangedEx (
+                    current_row_, index_in_group, gsm->listIndex ());
+    }
 
     GROUPLISTWIDGET_TRACE_EXIT;
 }
@@ -929,9 +2184,12 @@ void GroupListWidget::installUnderModel (GroupModel *value)
                  this, &GroupListWidget::underModelReset);
         connect (value, &GroupModel::groupingChanged,
                  this, &GroupListWidget::underGroupingChanged);
+        connect (value, &GroupModel::labelsChanged,
+                 this, &GroupListWidget::underLabelsChanged);
     }
     m_ = value;
     reinitDelegate ();
+    followBaseModel ();
     GROUPLISTWIDGET_TRACE_EXIT;
 }
 /* ========================================================================= */
@@ -948,11 +2206,22 @@ void GroupListWidget::uninstallUnderModel (bool b_delete)
                     this, &GroupListWidget::underModelReset);
         disconnect (m_, &GroupModel::groupingChanged,
                     this, &GroupListWidget::underGroupingChanged);
+        disconnect (m_, &GroupModel::labelsChanged,
+                    this, &GroupListWidget::underLabelsChanged);
+
+        // the groups are going away together with the model
+        int i_max = topLevelItemCount();
+        for (int i = 0; i < i_max; ++i) {
+            static_cast<GrpTreeItem *>(topLevelItem (i))->gsm_ = NULL;
+        }
+        discardState ();
+        selection_->clear ();
 
         if (b_delete)
             delete m_;
 
         m_ = NULL;
+        followBaseModel ();
     }
     GROUPLISTWIDGET_TRACE_EXIT;
 }
@@ -23,6 +23,18 @@ macro    (grouplistwidgetInit
         "groupsubmodel.h"
         "grouplistgroup.h"
         "grouplistwidget.h"
+        "grouppixmappyramid.h"
+        "groupgeometrycache.h"
+        "groupmodelstats.h"
+        "groupmemoryusage.h"
+        "groupframestats.h"
+        "grouptracer.h"
+        "grouprecorder.h"
+        "groupreplayer.h"
+        "groupcountingproxy.h"
+        "groupselection.h"
+        "groupselectionmodel.h"
+        "grouptreemodel.h"
         "models/groupm_columns.h")
     set(GROUPLISTWIDGET_SOURCES
         "groupmodel.cc"
@@ -30,6 +42,19 @@ macro    (grouplistwidgetInit
         "groupsubmodel.cc"
         "grouplistgroup.cc"
         "grouplistwidget.cc"
+        "grouppixmappyramid.cc"
+        "groupgeometrycache.cc"
+        "groupmodelstats.cc"
+        "groupmemoryusage.cc"
+        "groupframestats.cc"
+        "grouptracer.cc"
+        "grouprecorder.cc"
+        "groupreplayer.cc"
+        "groupcountingproxy.cc"
+        "grouplogging.cc"
+        "groupselection.cc"
+        "groupselectionmodel.cc"
+        "grouptreemodel.cc"
         "models/groupm_columns.cc")
     set(GROUPLISTWIDGET_QT_MODS
         Core Widgets)
@@ -14,21 +14,32 @@
 #include <QTreeWidget>
 #include <QListView>
 #include <QIcon>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QPointer>
+#include <grouplistwidget/groupmemoryusage.h>
+#include <grouplistwidget/groupframestats.h>
 
 QT_BEGIN_NAMESPACE
 class QAbstractItemModel;
+class QTimer;
+class QLabel;
 QT_END_NAMESPACE
 
 class GroupSubModel;
 class GroupModel;
 class GroupListGroup;
 class GrpTreeDeleg;
+class GrpTreeItem;
+class GroupSelection;
+class GroupGeometryCache;
 
 //! A list widget that can group the items.
 class GROUPLISTWIDGET_EXPORT GroupListWidget : public QTreeWidget {
     Q_OBJECT
 
     friend class GrpTreeDeleg;
+    friend class GroupListGroup;
 
 public:
 
@@ -104,7 +115,7 @@ public:
     //! Arrange items from left to right or from top to bottom
     QSize
     gridCell () {
-        if (grid_cell_.isNull()) {
+        if (!grid_cell_.isValid() || grid_cell_.isNull()) {
             grid_cell_ = computeGridCell ();
         }
         return grid_cell_;
@@ -146,6 +157,7 @@ public:
     setIconExpanded (
             const QIcon & value) {
         icon_group_expanded_ = value;
+        invalidateHeaderCache ();
     }
 
     //! Icon shown to the left of text when the group is expanded.
@@ -159,6 +171,7 @@ public:
     setIconCollapsed (
             const QIcon & value) {
         icon_group_collapsed_ = value;
+        invalidateHeaderCache ();
     }
 
     //! Icon shown to the left of text when the group is collapsed.
@@ -172,6 +185,7 @@ public:
     setGroupBackColor (
             const QColor & value) {
         group_back_ = value;
+        invalidateHeaderCache ();
     }
 
     //! The color for group background.
@@ -180,6 +194,149 @@ public:
         return group_back_;
     }
 
+    //! Repaint the group headers instead of using the cached ones.
+    void
+    invalidateHeaderCache ();
+
+    //! Changes each time the cached group headers become invalid.
+    int
+    headerCacheGeneration () const {
+        return header_generation_;
+    }
+
+    //! The cache for font metrics and item geometry.
+    GroupGeometryCache *
+    geometryCache () const {
+        return geometry_cache_;
+    }
+
+    //! Change the cache for font metrics and item geometry (NULL for global one).
+    void
+    setGeometryCache (
+            GroupGeometryCache * value);
+
+    //! Are the items of the groups painted into cached tiles?
+    bool
+    tileCaching () const {
+        return tile_caching_;
+    }
+
+    //! Paint the items of the groups into cached tiles.
+    void
+    setTileCaching (
+            bool value);
+
+    //! Are the lists for groups only created while they are visible?
+    bool
+    lazyViews () const {
+        return lazy_views_;
+    }
+
+    //! Only create the lists for groups while they are visible.
+    void
+    setLazyViews (
+            bool value);
+
+    //! Time (in milliseconds) a list stays hidden before being released.
+    int
+    lazyReleaseDelay () const {
+        return lazy_release_ms_;
+    }
+
+    //! Change the time (in milliseconds) a list stays hidden before being released.
+    void
+    setLazyReleaseDelay (
+            int value);
+
+    //! Are the lists created progressively, from the event loop?
+    bool
+    progressive () const {
+        return progressive_;
+    }
+
+    //! Create the lists for visible groups first and the rest from the event loop.
+    void
+    setProgressive (
+            bool value);
+
+    //! Time (in milliseconds) spent creating lists in each iteration of event loop.
+    int
+    sliceBudget () const {
+        return slice_budget_ms_;
+    }
+
+    //! Change the time (in milliseconds) spent creating lists in each iteration of event loop.
+    void
+    setSliceBudget (
+            int value) {
+        slice_budget_ms_ = qMax (1, value);
+    }
+
+    //! Are there lists left to be created in progressive mode?
+    bool
+    isPopulating () const;
+
+    //! The rows selected in all groups.
+    GroupSelection *
+    selection () const {
+        return selection_;
+    }
+
+    //! The way the user selects items in the lists.
+    QAbstractItemView::SelectionMode
+    listSelectionMode () const {
+        return list_selection_mode_;
+    }
+
+    //! Change the way the user selects items in the lists.
+    void
+    setListSelectionMode (
+            QAbstractItemView::SelectionMode value);
+
+    //! Number of unused lists kept to be reused by next rebuild.
+    int
+    viewPoolSize () const {
+        return view_pool_size_;
+    }
+
+    //! Change the number of unused lists kept to be reused by next rebuild.
+    void
+    setViewPoolSize (
+            int value) {
+        view_pool_size_ = qMax (0, value);
+    }
+
+    //! Estimated memory used by the model, the lists and the caches of this widget.
+    GroupMemoryUsage
+    memoryUsage () const;
+
+    //! Are the paint costs measured?
+    bool
+    diagnostics () const {
+        return diagnostics_;
+    }
+
+    //! Start or stop measuring the paint costs.
+    void
+    setDiagnostics (
+            bool value);
+
+    //! Are the paint costs shown over the viewport?
+    bool
+    diagnosticsOverlay () const {
+        return overlay_ != NULL;
+    }
+
+    //! Show or hide the paint costs over the viewport.
+    void
+    setDiagnosticsOverlay (
+            bool value);
+
+    //! The paint costs of the last frame that was measured.
+    const GroupFrameStats &
+    lastFrameStats () const {
+        return last_frame_;
+    }
 
 
 public slots:
@@ -239,6 +396,11 @@ signals:
             int row_in_list,
             int gsm);
 
+    //! The paint costs of a frame were measured (see setDiagnostics()).
+    void
+    frameMeasured (
+            const GroupFrameStats & stats);
+
 private slots:
 
     //! Before the actual changes are implemented.
@@ -255,12 +417,38 @@ private slots:
             int column,
             Qt::SortOrder);
 
+    //! The labels presented for each item have changed.
+    void
+    underLabelsChanged ();
+
     //! The selection in a listview changes.
     void
     listViewSelChange (
             const QModelIndex &current,
             const QModelIndex &previous);
 
+    //! The shared selection changed.
+    void
+    crossSelectionChange ();
+
+    //! Rows were inserted in base model.
+    void
+    baseRowsInserted (
+            const QModelIndex & parent,
+            int first,
+            int last);
+
+    //! Rows were removed from base model.
+    void
+    baseRowsRemoved (
+            const QModelIndex & parent,
+            int first,
+            int last);
+
+    //! The rows of base model were moved or rearranged.
+    void
+    baseRowsRearranged ();
+
     //! The actual function and parameters are extracted from sender properties.
     void
     genericSlot ();
@@ -270,6 +458,34 @@ private slots:
     itemClicked (
             const QModelIndex & item);
 
+    //! Create the lists for visible groups at next iteration of event loop.
+    void
+    scheduleMaterialize ();
+
+    //! Create the lists for groups that are visible.
+    void
+    materializeVisible ();
+
+    //! Release the lists for groups that were not visible for a while.
+    void
+    releaseHidden ();
+
+    //! Create some of the remaining lists in progressive mode.
+    void
+    populateSlice ();
+
+    //! Arrange the lists whose layout was deferred.
+    void
+    arangePending ();
+
+    //! Publish the paint costs of the frame that ended.
+    void
+    endFrame ();
+
+    //! Show the paint costs of the last frame in the overlay.
+    void
+    updateOverlay ();
+
 protected:
 
     //! Implement a default contextual menu.
@@ -287,8 +503,31 @@ protected:
     wheelEvent (
             QWheelEvent *);
 
+    //! Font changes invalidate the geometry of the items.
+    void
+    changeEvent (
+            QEvent * event);
+
+    //! Measures the time spent painting the tree in diagnostics mode.
+    void
+    paintEvent (
+            QPaintEvent * event);
+
 private:
 
+    //! The frame being measured (NULL if diagnostics are off).
+    GroupFrameStats *
+    frameStats ();
+
+    //! Copy the counters of the caches into a frame.
+    void
+    sampleCaches (
+            GroupFrameStats * stats) const;
+
+    //! Move the overlay to the top right corner of the viewport.
+    void
+    placeOverlay ();
+
     //! Populates the widget based on the current state of the model.
     void
     recreateFromGroup();
@@ -309,6 +548,74 @@ private:
             GroupSubModel *smdl,
             QTreeWidgetItem *tvi);
 
+    //! Make a list present the content of a group.
+    void
+    bindListView (
+            GroupListGroup * lv,
+            GroupSubModel * smdl);
+
+    //! Create the list for a group if it does not have one.
+    bool
+    ensureListView (
+            GrpTreeItem * it,
+            bool b_defer = false);
+
+    //! Vertical position of an item inside a list of given height.
+    int
+    itemOffset (
+            int index_in_group,
+            int list_height,
+            const QTreeWidgetItem * host);
+
+    //! The width of a list hosted by an item of the tree.
+    int
+    listWidth (
+            const QTreeWidgetItem * host) const;
+
+    //! Width of the frame around a list.
+    int
+    listFrameWidth () const;
+
+    //! Number of cells that fit in a line of a list.
+    int
+    itemsPerLine (
+            const QSize & cell,
+            const QTreeWidgetItem * host) const;
+
+    //! Find the item that presents a group.
+    GrpTreeItem *
+    itemForGroup (
+            const GroupSubModel * gsm) const;
+
+    //! Remember what the user sees before a rebuild.
+    void
+    captureState ();
+
+    //! Follow the structural changes of base model in the shared selection.
+    void
+    followBaseModel ();
+
+    //! Apply the state saved by captureState() after a rebuild.
+    void
+    restoreState ();
+
+    //! Forget the state saved by captureState().
+    void
+    discardState ();
+
+    //! Stop repainting the widget while its content is rebuilt.
+    void
+    holdUpdates ();
+
+    //! Repaint the widget once its content was rebuilt.
+    void
+    releaseUpdates ();
+
+    //! Hide the items that are not used and keep some of them for reuse.
+    void
+    recycleSurplus (
+            int used);
+
     //! Helper used to construct the contextual menu.
     QMenu *
     addColumnsToMenu (
@@ -324,10 +631,29 @@ private:
     void
     arangeLists ();
 
+    //! Makes sure that the list of a group shows all its content.
+    void
+    arangeList (
+            GrpTreeItem * it);
+
+    //! Can the size of a group be computed without creating its list?
+    bool
+    canEstimateGroups () const;
+
+    //! The size of the list for a group computed from the grid.
+    QSize
+    estimateGroupSize (
+            GroupSubModel * gsm,
+            const QTreeWidgetItem * host);
+
     //! Let the delegate cache geometry.
     void
     reinitDelegate ();
 
+    //! Recompute the geometry of the items and arrange the lists.
+    void
+    refreshGeometry ();
+
     QSize
     gridCellFromDelegate (
             QAbstractItemDelegate *delegate,
@@ -388,6 +714,42 @@ public:
     QIcon icon_group_expanded_; /**< Icon shown to the left of text when the group is expanded. */
     QIcon icon_group_collapsed_; /**< Icon shown to the left of text when the group is collapsed. */
     QColor group_back_; /**< the color for group background */
+    int header_generation_; /**< changes when the cached group headers become invalid */
+    GroupGeometryCache * geometry_cache_; /**< font metrics and item geometry (not owned) */
+    bool tile_caching_; /**< paint the items into cached tiles */
+    bool lazy_views_; /**< only create the lists for visible groups */
+    int lazy_release_ms_; /**< time a list stays hidden before being released */
+    int view_pool_size_; /**< number of unused lists kept for reuse */
+    bool updates_held_; /**< the updates were disabled for a rebuild */
+    bool updates_were_enabled_; /**< the state of the updates before the rebuild */
+    bool progressive_; /**< create the lists from the event loop */
+    int slice_budget_ms_; /**< time spent creating lists in one slice */
+    int populate_next_; /**< next top level item to get a list in progressive mode */
+    QSet<QString> collapsed_keys_; /**< groups that were collapsed before the rebuild */
+    QString anchor_key_; /**< the group at the top of the viewport before the rebuild */
+    int anchor_offset_; /**< the part of the anchor group that was scrolled out */
+    int saved_row_; /**< current row in base model before the rebuild */
+    bool state_saved_; /**< the state was captured and waits to be restored */
+    bool restoring_; /**< the current item is being restored */
+    QTimer * materialize_timer_; /**< creates the lists for visible groups */
+    QTimer * release_timer_; /**< releases the lists for hidden groups */
+    QTimer * populate_timer_; /**< creates the lists in progressive mode */
+    QTimer * arrange_timer_; /**< arranges the lists whose layout was deferred */
+    QList<QPointer<GroupListGroup> > arrange_pending_; /**< lists created without a layout */
+    GroupSelection * selection_; /**< the rows selected in all groups */
+    QPointer<QAbstractItemModel> selection_base_; /**< base model followed by the selection */
+    QPointer<GroupListGroup> current_lv_; /**< the list that has the current item */
+    QAbstractItemView::SelectionMode list_selection_mode_; /**< selection mode for the lists */
+    QElapsedTimer clock_; /**< time reference for last time groups were seen */
+    bool diagnostics_; /**< the paint costs are measured */
+    bool frame_open_; /**< a frame is being measured */
+    int frame_count_; /**< the number of frames that were measured */
+    GroupFrameStats frame_; /**< the frame being measured */
+    GroupFrameStats frame_base_; /**< the counters of the caches when the frame started */
+    GroupFrameStats last_frame_; /**< the last frame that was measured */
+    QTimer * frame_timer_; /**< ends the frame at next iteration of event loop */
+    QLabel * overlay_; /**< shows the paint costs over the viewport */
+    QTimer * overlay_timer_; /**< limits the rate at which the overlay changes */
 }; // GroupListWidget
 
 #endif // GUARD_GROUPLISTWIDGET_H_INCLUDE
@@ -0,0 +1,19 @@
+/**
+ * @file grouplogging.cc
+ * @brief Logging categories used by the library.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ *
+ * Warnings are enabled and debug messages are disabled by default;
+ * use QLoggingCategory::setFilterRules() or QT_LOGGING_RULES to change
+ * that, for example "grouplistwidget.compare.warning=false".
+ */
+#include "grouplistwidget-private.h"
+
+Q_LOGGING_CATEGORY(grpLogModel, "grouplistwidget.model", QtWarningMsg)
+Q_LOGGING_CATEGORY(grpLogCompare, "grouplistwidget.compare", QtWarningMsg)
+Q_LOGGING_CATEGORY(grpLogView, "grouplistwidget.view", QtWarningMsg)
+Q_LOGGING_CATEGORY(grpLogDelegate, "grouplistwidget.delegate", QtWarningMsg)
+Q_LOGGING_CATEGORY(grpLogTrace, "grouplistwidget.trace", QtWarningMsg)
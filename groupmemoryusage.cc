@@ -0,0 +1,194 @@
+/**
+ * @file groupmemoryusage.cc
+ * @brief Definitions for GroupMemoryUsage class.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#include "groupmemoryusage.h"
+
+#include <QImage>
+#include <QList>
+#include <QPixmap>
+#include <QStringList>
+
+/**
+ * @class GroupMemoryUsage
+ *
+ * The values are estimates computed from the sizes of the containers
+ * and of the objects they hold; the private data of Qt objects and the
+ * allocator overhead are not included. Data that is implicitly shared
+ * (strings, variants, pixmaps) is counted for each holder. Pixmaps
+ * held by QPixmapCache are counted while they are still in the cache.
+ */
+
+/* ------------------------------------------------------------------------- */
+GroupMemoryUsage::GroupMemoryUsage ()
+{
+    clear ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupMemoryUsage::clear ()
+{
+    for (int i = 0; i < PartCount; ++i) {
+        bytes_[i] = 0;
+        count_[i] = 0;
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupMemoryUsage & GroupMemoryUsage::operator+= (const GroupMemoryUsage & other)
+{
+    for (int i = 0; i < PartCount; ++i) {
+        bytes_[i] += other.bytes_[i];
+        count_[i] += other.count_[i];
+    }
+    return *this;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+qint64 GroupMemoryUsage::totalBytes () const
+{
+    qint64 result = 0;
+    for (int i = 0; i < PartCount; ++i) {
+        result += bytes_[i];
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+const char * GroupMemoryUsage::partName (Part part)
+{
+    switch (part) {
+    case PartGroups: return "groups";
+    case PartMappings: return "mappings";
+    case PartKeys: return "keys";
+    case PartLabels: return "labels";
+    case PartRowIndex: return "row_index";
+    case PartItemCache: return "item_cache";
+    case PartTextCache: return "text_cache";
+    case PartPixmapLevels: return "pixmap_levels";
+    case PartTiles: return "tiles";
+    case PartHeaders: return "headers";
+    case PartGeometry: return "geometry";
+    case PartViews: return "views";
+    case PartSelection: return "selection";
+    default: return "";
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QString GroupMemoryUsage::toString () const
+{
+    QString result;
+    for (int i = 0; i < PartCount; ++i) {
+        if ((bytes_[i] == 0) && (count_[i] == 0))
+            continue;
+        result.append (QString ("%1 %2 bytes in %3\n")
+                       .arg (partName (Part (i)), -14)
+                       .arg (bytes_[i], 12)
+                       .arg (count_[i]));
+    }
+    result.append (QString ("%1 %2 bytes\n")
+                   .arg ("total", -14).arg (totalBytes (), 12));
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+qint64 GroupMemoryUsage::stringBytes (const QString & value)
+{
+    if (value.isNull ())
+        return 0;
+    return sizeof (QArrayData) + (value.capacity () + 1) * sizeof (QChar);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Small values are stored inside the variant; larger ones are
+ * allocated on the heap.
+ */
+qint64 GroupMemoryUsage::variantBytes (const QVariant & value)
+{
+    switch (value.userType ()) {
+    case QMetaType::UnknownType:
+        return 0;
+    case QMetaType::QString:
+        return stringBytes (value.toString ());
+    case QMetaType::QByteArray:
+        return sizeof (QArrayData) + value.toByteArray ().capacity () + 1;
+    case QMetaType::QStringList: {
+        QStringList lst = value.toStringList ();
+        qint64 result = listBytes (lst.count ());
+        foreach (const QString & s, lst) {
+            result += stringBytes (s);
+        }
+        return result; }
+    case QMetaType::QVariantList: {
+        QVariantList lst = value.toList ();
+        qint64 result = listBytes (lst.count ()) + lst.count () * sizeof (QVariant);
+        foreach (const QVariant & v, lst) {
+            result += variantBytes (v);
+        }
+        return result; }
+    case QMetaType::QPixmap:
+        return pixmapBytes (value.value<QPixmap> ());
+    case QMetaType::QImage:
+        return imageBytes (value.value<QImage> ());
+    default: {
+        int size = QMetaType::sizeOf (value.userType ());
+        return size > int (sizeof (double)) ? size + 2 * sizeof (void*) : 0; }
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+qint64 GroupMemoryUsage::pixmapBytes (const QPixmap & value)
+{
+    if (value.isNull ())
+        return 0;
+    return qint64 (value.width ()) * value.height () * value.depth () / 8;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+qint64 GroupMemoryUsage::imageBytes (const QImage & value)
+{
+    if (value.isNull ())
+        return 0;
+    return qint64 (value.bytesPerLine ()) * value.height ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+qint64 GroupMemoryUsage::listBytes (int count)
+{
+    return sizeof (QListData::Data) + qint64 (count) * sizeof (void*);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+qint64 GroupMemoryUsage::vectorBytes (int capacity, int item_size)
+{
+    return sizeof (QArrayData) + qint64 (capacity) * item_size;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * A QHash node (next pointer, hash, key, value) and the links QCache
+ * keeps for its least recently used list.
+ */
+qint64 GroupMemoryUsage::cacheNodeBytes ()
+{
+    return 6 * sizeof (void*);
+}
+/* ========================================================================= */
@@ -0,0 +1,135 @@
+/**
+ * @file groupmemoryusage.h
+ * @brief Declarations for GroupMemoryUsage class
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#ifndef GUARD_GROUPMEMORYUSAGE_H_INCLUDE
+#define GUARD_GROUPMEMORYUSAGE_H_INCLUDE
+
+#include <grouplistwidget/grouplistwidget-config.h>
+#include <QString>
+#include <QVariant>
+#include <QMetaType>
+
+QT_BEGIN_NAMESPACE
+class QPixmap;
+class QImage;
+QT_END_NAMESPACE
+
+//! Estimated memory used by the parts of a model or widget.
+class GROUPLISTWIDGET_EXPORT GroupMemoryUsage {
+
+public:
+
+    //! The parts that are accounted.
+    enum Part {
+        PartGroups = 0, /**< GroupSubModel objects and the list holding them */
+        PartMappings, /**< the rows of each group (GroupSubModel::mapping()) */
+        PartKeys, /**< group keys */
+        PartLabels, /**< group labels and the list of item labels */
+        PartRowIndex, /**< reverse index from rows in base model to groups */
+        PartItemCache, /**< values cached by GroupModel::itemData() */
+        PartTextCache, /**< labels laid out by GroupListDelegate */
+        PartPixmapLevels, /**< downscaled images in GroupPixmapPyramid */
+        PartTiles, /**< tiles rendered by the lists */
+        PartHeaders, /**< rendered group headers */
+        PartGeometry, /**< font metrics and item geometry */
+        PartViews, /**< GroupListGroup objects */
+        PartSelection, /**< the rows selected in all groups */
+        PartCount
+    };
+
+    //! Default constructor.
+    GroupMemoryUsage ();
+
+    //! Forget all values.
+    void
+    clear ();
+
+    //! Account some memory to a part.
+    void
+    add (
+            Part part,
+            qint64 bytes,
+            qint64 count = 1) {
+        bytes_[part] += bytes;
+        count_[part] += count;
+    }
+
+    //! Add the values of another instance.
+    GroupMemoryUsage &
+    operator+= (
+            const GroupMemoryUsage & other);
+
+    //! Bytes used by a part.
+    qint64
+    bytes (
+            Part part) const {
+        return bytes_[part];
+    }
+
+    //! Number of objects (groups, rows, cache entries) in a part.
+    qint64
+    count (
+            Part part) const {
+        return count_[part];
+    }
+
+    //! Bytes used by all parts.
+    qint64
+    totalBytes () const;
+
+    //! Name of a part.
+    static const char *
+    partName (
+            Part part);
+
+    //! One line for each part that is not empty.
+    QString
+    toString () const;
+
+    //! Heap memory used by a string.
+    static qint64
+    stringBytes (
+            const QString & value);
+
+    //! Heap memory used by a variant, in addition to sizeof(QVariant).
+    static qint64
+    variantBytes (
+            const QVariant & value);
+
+    //! Memory used by the pixels of a pixmap.
+    static qint64
+    pixmapBytes (
+            const QPixmap & value);
+
+    //! Memory used by the pixels of an image.
+    static qint64
+    imageBytes (
+            const QImage & value);
+
+    //! Heap memory used by a QList of items that are stored in place.
+    static qint64
+    listBytes (
+            int count);
+
+    //! Heap memory used by a QVector.
+    static qint64
+    vectorBytes (
+            int capacity,
+            int item_size);
+
+    //! Overhead of an entry in QCache or QHash.
+    static qint64
+    cacheNodeBytes ();
+
+private:
+    qint64 bytes_[PartCount]; /**< bytes for each part */
+    qint64 count_[PartCount]; /**< objects in each part */
+};
+Q_DECLARE_METATYPE(GroupMemoryUsage)
+
+#endif // GUARD_GROUPMEMORYUSAGE_H_INCLUDE
@@ -9,6 +9,7 @@
 
 #include "groupmodel.h"
 #include "groupsubmodel.h"
+#include "grouptracer.h"
 #include "grouplistwidget-private.h"
 #include <assert.h>
 #include <QAbstractItemModel>
@@ -83,7 +84,16 @@ GroupModel::GroupModel (QAbstractItemModel * model, QObject * parent) :
     user_data_(),
     groups_(),
     supress_signals_(false),
-    additional_labels_()
+    additional_labels_(),
+    item_cache_bytes_(0),
+    item_cache_(512),
+    row_group_(),
+    row_pos_(),
+    row_index_dirty_(true),
+    stats_(),
+    last_stats_(),
+    stats_depth_(0),
+    stats_timer_()
 {
     GROUPLISTWIDGET_TRACE_ENTRY;
     additional_labels_.append (ModelId(0, Qt::DisplayRole));
@@ -118,12 +128,18 @@ void GroupModel::setBaseModel (
 {
     GROUPLISTWIDGET_TRACE_ENTRY;
     if (baseModel () == model) {
-        GROUPLISTWIDGET_DEBUGM("Attempt to install same model "
-                               "twice blocked.\n");
+        GROUPLISTWIDGET_LOG_WARNING(
+                    grpLogModel,
+                    "Attempt to install same model twice blocked.");
         return;
     }
 
-    emit modelAboutToBeReset();
+    GROUPLISTWIDGET_TRACE_SCOPE("GroupModel::setBaseModel");
+    GROUPLISTWIDGET_STATS_OPERATION(this, "setBaseModel");
+    {
+        GROUPLISTWIDGET_STATS_PHASE(this, PhaseSignals);
+        emit modelAboutToBeReset();
+    }
     supress_signals_ = true;
 
     installBaseModel (model);
@@ -141,7 +157,12 @@ void GroupModel::setBaseModel (
     }
 
     supress_signals_ = false;
-    emit modelReset();
+    {
+        GROUPLISTWIDGET_TRACE_SCOPE("modelReset");
+        GROUPLISTWIDGET_STATS_PHASE(this, PhaseSignals);
+        GROUPLISTWIDGET_STATS_COUNT(this, CountResets, 1);
+        emit modelReset();
+    }
 
     GROUPLISTWIDGET_TRACE_EXIT;
 }
@@ -189,6 +210,16 @@ void GroupModel::installBaseModel (QAbstractItemModel * value)
                  this, &GroupModel::modelReset);
         connect (value, &QAbstractItemModel::dataChanged,
                  this, &GroupModel::baseModelDataChange);
+        connect (value, &QAbstractItemModel::rowsInserted,
+                 this, &GroupModel::baseModelStructureChange);
+        connect (value, &QAbstractItemModel::rowsRemoved,
+                 this, &GroupModel::baseModelStructureChange);
+        connect (value, &QAbstractItemModel::rowsMoved,
+                 this, &GroupModel::baseModelStructureChange);
+        connect (value, &QAbstractItemModel::layoutChanged,
+                 this, &GroupModel::baseModelStructureChange);
+        connect (value, &QAbstractItemModel::modelReset,
+                 this, &GroupModel::baseModelStructureChange);
 //        connect (value, &QAbstractItemModel::rowsRemoved,
 //                 this, &GroupModel::baseModelRowsRemoved);
     }
@@ -210,6 +241,16 @@ void GroupModel::uninstallBaseModel (bool do_delete)
                     this, &GroupModel::modelReset);
         disconnect (m_base_, &QAbstractItemModel::dataChanged,
                     this, &GroupModel::baseModelDataChange);
+        disconnect (m_base_, &QAbstractItemModel::rowsInserted,
+                    this, &GroupModel::baseModelStructureChange);
+        disconnect (m_base_, &QAbstractItemModel::rowsRemoved,
+                    this, &GroupModel::baseModelStructureChange);
+        disconnect (m_base_, &QAbstractItemModel::rowsMoved,
+                    this, &GroupModel::baseModelStructureChange);
+        disconnect (m_base_, &QAbstractItemModel::layoutChanged,
+                    this, &GroupModel::baseModelStructureChange);
+        disconnect (m_base_, &QAbstractItemModel::modelReset,
+                    this, &GroupModel::baseModelStructureChange);
 //        disconnect (m_base_, &QAbstractItemModel::rowsRemoved,
 //                    this, &GroupModel::baseModelRowsRemoved);
 
@@ -218,6 +259,8 @@ void GroupModel::uninstallBaseModel (bool do_delete)
     }
 
     m_base_ = NULL;
+    item_cache_.clear ();
+    row_index_dirty_ = true;
     GROUPLISTWIDGET_TRACE_EXIT;
 }
 /* ========================================================================= */
@@ -228,6 +271,19 @@ void GroupModel::baseModelDataChange (
         const QVector<int> &roles)
 {
     GROUPLISTWIDGET_TRACE_ENTRY;
+    int first = qMin (topLeft.row(), bottomRight.row());
+    int last = qMax (topLeft.row(), bottomRight.row());
+    if (last - first > item_cache_.count()) {
+        foreach (int key, item_cache_.keys()) {
+            if ((key >= first) && (key <= last))
+                item_cache_.remove (key);
+        }
+    } else {
+        for (int i = first; i <= last; ++i) {
+            item_cache_.remove (i);
+        }
+    }
+
     if (groups_.count() > 0) {
         int i = qMin (topLeft.row(), bottomRight.row());
         int i_max = i + qAbs (topLeft.row() - bottomRight.row()) + 1;
@@ -235,9 +291,10 @@ void GroupModel::baseModelDataChange (
             int index_in_group = -1;
             GroupSubModel * grp = groupForRow (i, &index_in_group);
             if (grp == NULL) {
-                GROUPLISTWIDGET_DEBUGM(
+                GROUPLISTWIDGET_LOG_WARNING(
+                            grpLogModel,
                             "Received word that row %d changed in "
-                            "base model but it was not found in groups\n",
+                            "base model but it was not found in groups",
                             i);
             } else {
                 grp->baseModelDataChange (
@@ -249,6 +306,18 @@ void GroupModel::baseModelDataChange (
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+/**
+ * Rows were inserted, removed or moved in base model, so the values
+ * cached for rows and the row index are no longer valid.
+ */
+void GroupModel::baseModelStructureChange ()
+{
+    item_cache_.clear ();
+    row_index_dirty_ = true;
+}
+/* ========================================================================= */
+
 /* ------------------------------------------------------------------------- */
 void GroupModel::baseModelRowsRemoved (
         const QModelIndex & /*parent*/, int first, int last)
@@ -261,9 +330,10 @@ void GroupModel::baseModelRowsRemoved (
             int index_in_group = -1;
             GroupSubModel * grp = groupForRow (i, &index_in_group);
             if (grp == NULL) {
-                GROUPLISTWIDGET_DEBUGM(
+                GROUPLISTWIDGET_LOG_WARNING(
+                            grpLogModel,
                             "Received word that row %d was removed in "
-                            "base model but it was not found in groups\n",
+                            "base model but it was not found in groups",
                             i);
             } else {
                 QList<int> rem_lst = affected.value (
@@ -312,8 +382,9 @@ void GroupModel::baseModelRowsRemoved (
 
 /* ------------------------------------------------------------------------- */
 /**
- * There is no internal reverse mapping from rows to groups, so this is an
- * expensive method as it has to search on average half the rows.
+ * The model keeps a reverse mapping from rows to groups that is rebuilt
+ * (in linear time) on first call after the groups changed; other calls
+ * take constant time.
  *
  * @param base_row The 0 based index in the base model.
  * @param index_in_group if found, this will hold the index inside the group
@@ -324,21 +395,56 @@ GroupSubModel * GroupModel::groupForRow (
         int base_row, int * index_in_group)
 {
     GROUPLISTWIDGET_TRACE_ENTRY;
-    foreach(GroupSubModel * subm, groups_) {
-        int idx = subm->mapping ().indexOf (base_row);
-        if (idx != -1) {
-            if (index_in_group != NULL) {
-                if (sort_dir_ == Qt::AscendingOrder) {
-                    *index_in_group = idx;
-                } else {
-                    *index_in_group = subm->rowCount() - idx - 1;
-                }
+    if (row_index_dirty_)
+        rebuildRowIndex ();
+
+    if ((base_row < 0) || (base_row >= row_group_.count ()))
+        return NULL;
+    int g = row_group_.at (base_row);
+    if (g == -1)
+        return NULL;
+
+    GroupSubModel * subm = groups_.at (g);
+    if (index_in_group != NULL) {
+        int idx = row_pos_.at (base_row);
+        if (sort_dir_ == Qt::AscendingOrder) {
+            *index_in_group = idx;
+        } else {
+            *index_in_group = subm->rowCount() - idx - 1;
+        }
+    }
+    GROUPLISTWIDGET_TRACE_EXIT;
+    return subm;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Rows in groups that are outside the range of the base model are
+ * ignored; they only show up when base model changed and the
+ * groups were not rebuilt yet.
+ */
+void GroupModel::rebuildRowIndex () const
+{
+    GROUPLISTWIDGET_TRACE_ENTRY;
+    int row_max = baseModel () == NULL ? 0 : baseModel ()->rowCount ();
+    row_group_.fill (-1, row_max);
+    row_pos_.fill (-1, row_max);
+
+    int g_max = groups_.count ();
+    for (int g = 0; g < g_max; ++g) {
+        const QList<int> & map = groups_.at (g)->mapping ();
+        int i_max = map.count ();
+        for (int i = 0; i < i_max; ++i) {
+            int r = map.at (i);
+            if ((r >= 0) && (r < row_max)) {
+                row_group_[r] = g;
+                row_pos_[r] = i;
             }
-            return subm;
         }
     }
+    row_index_dirty_ = false;
     GROUPLISTWIDGET_TRACE_EXIT;
-    return NULL;
 }
 /* ========================================================================= */
 
@@ -347,6 +453,9 @@ void GroupModel::setPixmapColumn (int column)
 {
     GROUPLISTWIDGET_TRACE_ENTRY;
     pixmap_.setColumn (column);
+    item_cache_.clear ();
+    if (!supress_signals_)
+        emit operationPerformed (OpPixmapColumn, column);
     GROUPLISTWIDGET_TRACE_EXIT;
 }
 /* ========================================================================= */
@@ -363,6 +472,9 @@ void GroupModel::setPixmapRole (Qt::ItemDataRole role)
 {
     GROUPLISTWIDGET_TRACE_ENTRY;
     pixmap_.setRole (role);
+    item_cache_.clear ();
+    if (!supress_signals_)
+        emit operationPerformed (OpPixmapRole, role);
     GROUPLISTWIDGET_TRACE_EXIT;
 }
 /* ========================================================================= */
@@ -391,6 +503,44 @@ QPixmap GroupModel::pixmap (int row) const
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+/**
+ * The values are retrieved from base model in a single pass and a
+ * small number of rows is kept in a cache, so that painting an item
+ * that presents several labels costs a single lookup. The cache follows
+ * the changes in base model.
+ *
+ * @param base_row Indicates the item using its zero-based index in base model.
+ * @return the values; base_row_ member is -1 if there is no base model
+ */
+GroupItemData GroupModel::itemData (int base_row) const
+{
+    GroupItemCacheEntry * cached = item_cache_.object (base_row);
+    if (cached != NULL)
+        return cached->data_;
+
+    GroupItemData result;
+    if ((baseModel () == NULL) || (base_row < 0))
+        return result;
+
+    result.base_row_ = base_row;
+    if (pixmap_.column () != -1) {
+        result.pixmap_ = baseModel ()->index (
+                    base_row, pixmap_.column ()).data (pixmap_.role ());
+    }
+    result.labels_.reserve (additional_labels_.count ());
+    foreach (const ModelId & mid, additional_labels_) {
+        result.labels_.append (
+                    baseModel ()->index (
+                        base_row, mid.column ()).data (mid.role ()));
+    }
+
+    item_cache_.insert (
+                base_row, new GroupItemCacheEntry (result, &item_cache_bytes_));
+    return result;
+}
+/* ========================================================================= */
+
 /* ------------------------------------------------------------------------- */
 int GroupModel::count() const
 {
@@ -406,13 +556,16 @@ bool GroupModel::remove (int row)
 {
     bool b_ret = false;
     if (baseModel () == NULL) {
-        GROUPLISTWIDGET_DEBUGM("No base model to remove from\n");
+        GROUPLISTWIDGET_LOG_WARNING(
+                    grpLogModel,
+                    "No base model to remove from");
     } else {
         int row_max = baseModel()->rowCount ();
         if ((row < 0) || (row >= row_max)) {
-            GROUPLISTWIDGET_DEBUGM("Row %d is outside valid range "
-                                   "[0..%d)\n",
-                                   row, row_max);
+            GROUPLISTWIDGET_LOG_WARNING(
+                        grpLogModel,
+                        "Row %d is outside valid range [0..%d)",
+                        row, row_max);
         } else {
             b_ret = baseModel ()->removeRow (row);
             if (b_ret) {
@@ -439,8 +592,10 @@ bool GroupModel::remove (int row)
  */
 bool GroupModel::setGroupingColumn (int column)
 {
+    GROUPLISTWIDGET_TRACE_SCOPE("GroupModel::setGroupingColumn");
     bool b_ret = false;
     GROUPLISTWIDGET_TRACE_ENTRY;
+    GROUPLISTWIDGET_STATS_OPERATION(this, "setGroupingColumn");
     for (;;) {
 
         if (column == -1) {
@@ -452,8 +607,10 @@ bool GroupModel::setGroupingColumn (int column)
                 break;
             }
 
-            if (!supress_signals_)
+            if (!supress_signals_) {
+                GROUPLISTWIDGET_STATS_PHASE(this, PhaseSignals);
                 emit modelAboutToBeReset ();
+            }
             if (baseModel() != NULL) {
                 clearAllGroups ();
                 group_.setColumn (column);
@@ -461,8 +618,12 @@ bool GroupModel::setGroupingColumn (int column)
             } else {
                 group_.setColumn (column);
             }
-            if (!supress_signals_)
+            if (!supress_signals_) {
+                GROUPLISTWIDGET_TRACE_SCOPE("modelReset");
+                GROUPLISTWIDGET_STATS_PHASE(this, PhaseSignals);
+                GROUPLISTWIDGET_STATS_COUNT(this, CountResets, 1);
                 emit modelReset ();
+            }
 
             b_ret = true;
             break;
@@ -472,25 +633,31 @@ bool GroupModel::setGroupingColumn (int column)
         if (baseModel() != NULL) {
             int col_max = baseModel()->columnCount ();
             if ((column < 0) || (column >= col_max)) {
-                GROUPLISTWIDGET_DEBUGM("Grouping column %d is outside valid range "
-                                       "[0..%d)\n",
-                                       column, col_max);
+                GROUPLISTWIDGET_LOG_WARNING(
+                            grpLogModel,
+                            "Grouping column %d is outside valid range "
+                            "[0..%d)",
+                            column, col_max);
                 break;
             }
         }
         /*if (column == sort_.column ()) {
             if (group_.role () == sort_.role ()) {
-                GROUPLISTWIDGET_DEBUGM("Grouping column can't be the same as "
-                                       "sorting column (%d)\n",
-                                       column);
+                GROUPLISTWIDGET_LOG_WARNING(
+                            grpLogModel,
+                            "Grouping column can't be the same as sorting "
+                            "column (%d)",
+                            column);
                 return false;
             }
         }*/
         if (column == pixmap_.column ()) {
             if (group_.role () == pixmap_.role ()) {
-                GROUPLISTWIDGET_DEBUGM("Grouping column can't be the same as "
-                                       "pixmap column (%d)\n",
-                                       column);
+                GROUPLISTWIDGET_LOG_WARNING(
+                            grpLogModel,
+                            "Grouping column can't be the same as pixmap "
+                            "column (%d)",
+                            column);
                 break;
             }
         }
@@ -501,8 +668,10 @@ bool GroupModel::setGroupingColumn (int column)
             break;
         }
 
-        if (!supress_signals_)
+        if (!supress_signals_) {
+            GROUPLISTWIDGET_STATS_PHASE(this, PhaseSignals);
             emit modelAboutToBeReset ();
+        }
         if (baseModel () != NULL) {
             clearAllGroups ();
             group_.setColumn (column);
@@ -510,12 +679,18 @@ bool GroupModel::setGroupingColumn (int column)
         } else {
             group_.setColumn (column);
         }
-        if (!supress_signals_)
+        if (!supress_signals_) {
+            GROUPLISTWIDGET_TRACE_SCOPE("modelReset");
+            GROUPLISTWIDGET_STATS_PHASE(this, PhaseSignals);
+            GROUPLISTWIDGET_STATS_COUNT(this, CountResets, 1);
             emit modelReset ();
+        }
 
         b_ret = true;
         break;
     }
+    if (b_ret && !supress_signals_)
+        emit operationPerformed (OpGroupingColumn, column);
     return b_ret;
     GROUPLISTWIDGET_TRACE_EXIT;
 }
@@ -525,9 +700,10 @@ bool GroupModel::setGroupingColumn (int column)
 GroupSubModel * GroupModel::group (int idx) const
 {
     if ((idx < 0) || (idx >= groups_.count())) {
-        GROUPLISTWIDGET_DEBUGM("Group index %d is outside valid range "
-                               "[0..%d)\n",
-                               idx, groups_.count());
+        GROUPLISTWIDGET_LOG_WARNING(
+                    grpLogModel,
+                    "Group index %d is outside valid range [0..%d)",
+                    idx, groups_.count());
         return NULL;
     }
     if (group_dir_ == Qt::AscendingOrder) {
@@ -553,7 +729,9 @@ GroupSubModel * GroupModel::group (int idx) const
  */
 bool GroupModel::setSortingColumn (int column)
 {
+    GROUPLISTWIDGET_TRACE_SCOPE("GroupModel::setSortingColumn");
     GROUPLISTWIDGET_TRACE_ENTRY;
+    GROUPLISTWIDGET_STATS_OPERATION(this, "setSortingColumn");
     bool b_ret = false;
     for (;;) {
 
@@ -570,8 +748,10 @@ bool GroupModel::setSortingColumn (int column)
             if (baseModel() != NULL)
                 performUnsorting ();
 
-            if (!supress_signals_)
+            if (!supress_signals_) {
+                GROUPLISTWIDGET_STATS_PHASE(this, PhaseSignals);
                 emit sortingChanged (sort_.column (), sort_dir_);
+            }
 
             b_ret = true;
             break;
@@ -580,25 +760,30 @@ bool GroupModel::setSortingColumn (int column)
         // make sure provided index is valid
         if (baseModel () != NULL) {
             if ((column < 0) || (column >= baseModel()->columnCount ())) {
-                GROUPLISTWIDGET_DEBUGM("Sorting column %d is outside valid range "
-                                       "[0..%d)\n",
-                                       column, baseModel()->columnCount ());
+                GROUPLISTWIDGET_LOG_WARNING(
+                            grpLogModel,
+                            "Sorting column %d is outside valid range [0..%d)",
+                            column, baseModel()->columnCount ());
                 return false;
             }
         }
         /*if (column == group_.column ()) {
             if (group_.role () == sort_.role ()) {
-                GROUPLISTWIDGET_DEBUGM("Sorting column can't be the same as "
-                                       "grouping column (%d)\n",
-                                       column);
+                GROUPLISTWIDGET_LOG_WARNING(
+                            grpLogModel,
+                            "Sorting column can't be the same as grouping "
+                            "column (%d)",
+                            column);
                 return false;
             }
         }*/
         if (column == pixmap_.column ()) {
             if (sort_.role () == pixmap_.role ()) {
-                GROUPLISTWIDGET_DEBUGM("Sorting column can't be the same as "
-                                       "pixmap column (%d)\n",
-                                       column);
+                GROUPLISTWIDGET_LOG_WARNING(
+                            grpLogModel,
+                            "Sorting column can't be the same as pixmap "
+                            "column (%d)",
+                            column);
                 return false;
             }
         }
@@ -612,12 +797,16 @@ bool GroupModel::setSortingColumn (int column)
         sort_.setColumn (column);
         if (baseModel() != NULL)
             performSorting ();
-        if (!supress_signals_)
+        if (!supress_signals_) {
+            GROUPLISTWIDGET_STATS_PHASE(this, PhaseSignals);
             emit sortingChanged (sort_.column (), sort_dir_);
+        }
 
         b_ret = true;
         break;
     }
+    if (b_ret && !supress_signals_)
+        emit operationPerformed (OpSortingColumn, column);
     GROUPLISTWIDGET_TRACE_EXIT;
     return b_ret;
 }
@@ -626,13 +815,18 @@ bool GroupModel::setSortingColumn (int column)
 /* ------------------------------------------------------------------------- */
 void GroupModel::setSortingDirection(Qt::SortOrder value)
 {
+    GROUPLISTWIDGET_TRACE_SCOPE("GroupModel::setSortingDirection");
     GROUPLISTWIDGET_TRACE_ENTRY;
+    GROUPLISTWIDGET_STATS_OPERATION(this, "setSortingDirection");
     sort_dir_ = value;
     if (!supress_signals_) {
+        GROUPLISTWIDGET_STATS_PHASE(this, PhaseSignals);
+        GROUPLISTWIDGET_STATS_COUNT(this, CountResets, groups_.count ());
         foreach (GroupSubModel * subm, groups_) {
             subm->signalReset ();
         }
         emit sortingChanged (sort_.column (), sort_dir_);
+        emit operationPerformed (OpSortingDirection, value);
     }
     GROUPLISTWIDGET_TRACE_EXIT;
 }
@@ -646,7 +840,9 @@ void GroupModel::addLabels (
     foreach (int i, col_lst) {
         additional_labels_.append (ModelId (i, role));
     }
+    item_cache_.clear ();
     emit modelReset ();
+    emit labelsChanged ();
     // resetAllSubGroups ();
 }
 /* ========================================================================= */
@@ -662,15 +858,14 @@ QString GroupModel::itemLabel (int item, int pos) const
     for (;;) {
         ModelId mid = label (pos);
         if (!mid.isValid()) {
-            GROUPLISTWIDGET_DEBUGM(
-                        "Can't retrieve label for invalid position %d.\n",
+            GROUPLISTWIDGET_LOG_WARNING(
+                        grpLogModel,
+                        "Can't retrieve label for invalid position %d.",
                         pos);
             break;
         }
 
-        result = baseModel()->index (
-                    item, mid.column())
-                .data (mid.role()).toString();
+        result = itemData (item).labels_.value (pos).toString();
 
         break;
     }
@@ -685,6 +880,7 @@ QString GroupModel::itemLabel (int item, int pos) const
  */
 void GroupModel::buildAllGroups ()
 {
+    GROUPLISTWIDGET_TRACE_SCOPE("GroupModel::buildAllGroups");
     GROUPLISTWIDGET_TRACE_ENTRY;
     Q_ASSERT (baseModel () != NULL);
     Q_ASSERT (group_.column () >= 0);
@@ -692,19 +888,36 @@ void GroupModel::buildAllGroups ()
     int i_max = baseModel ()->rowCount();
     int group_index = 0;
 
+    // read all keys first so the time spent in base model is separate
+    QVector<QVariant> keys (i_max);
+    {
+        GROUPLISTWIDGET_STATS_PHASE(this, PhaseKeys);
+        for (int i = 0; i < i_max; ++i) {
+            keys[i] = baseModel ()->index (i, group_.column ()).data (group_.role ());
+        }
+        GROUPLISTWIDGET_STATS_COUNT(this, CountData, i_max);
+    }
+
 #   define NEW_GROUP \
     GroupSubModel * newm = new GroupSubModel ( \
-                this, iter_data, midx.data(group_label_role_).toString()); \
-    newm->appendRecord (i);
+                this, iter_data, \
+                baseModel ()->index (i, group_.column ()).data ( \
+                    group_label_role_).toString()); \
+    newm->appendRecord (i); \
+    GROUPLISTWIDGET_STATS_ONLY(++created);
+
+    GROUPLISTWIDGET_STATS_PHASE(this, PhaseBucketing);
+    GROUPLISTWIDGET_STATS_ONLY(qint64 compares = 0);
+    GROUPLISTWIDGET_STATS_ONLY(qint64 created = 0);
 
     // go through all records in the base model
     for (int i = 0; i < i_max; ++i) {
-        QModelIndex midx = baseModel ()->index (i, group_.column ());
-        QVariant iter_data = midx.data (group_.role ());
+        const QVariant & iter_data = keys.at (i);
 
         bool b_found = false;
         group_index = 0;
         foreach(GroupSubModel * subm, groups_) {
+            GROUPLISTWIDGET_STATS_ONLY(++compares);
             ComparisonReslt res = group_func_(
                         this, group_.column (), iter_data,
                         subm->groupKey ());
@@ -730,6 +943,11 @@ void GroupModel::buildAllGroups ()
             groups_.append (newm);
         }
     }
+#   undef NEW_GROUP
+
+    GROUPLISTWIDGET_STATS_COUNT(this, CountCompare, compares);
+    GROUPLISTWIDGET_STATS_COUNT(this, CountData, created);
+    GROUPLISTWIDGET_STATS_COUNT(this, CountGroupsCreated, created);
 
     // let every group know their place
     group_index = 0;
@@ -748,10 +966,13 @@ void GroupModel::buildAllGroups ()
  */
 void GroupModel::buildNoGroupingGroup ()
 {
+    GROUPLISTWIDGET_TRACE_SCOPE("GroupModel::buildNoGroupingGroup");
     GROUPLISTWIDGET_TRACE_ENTRY;
     GroupSubModel * newm = new GroupSubModel (
                 this, QVariant(),
                 tr("(ungrouped)"));
+    GROUPLISTWIDGET_STATS_COUNT(this, CountGroupsCreated, 1);
+    GROUPLISTWIDGET_STATS_PHASE(this, PhaseBucketing);
 
     // go through all records in the base model
     int i_max = baseModel ()->rowCount();
@@ -776,6 +997,7 @@ void GroupModel::clearAllGroups ()
     GROUPLISTWIDGET_TRACE_ENTRY;
     qDeleteAll (groups_);
     groups_.clear ();
+    row_index_dirty_ = true;
     GROUPLISTWIDGET_TRACE_EXIT;
 }
 /* ========================================================================= */
@@ -786,7 +1008,9 @@ void GroupModel::clearAllGroups ()
  */
 void GroupModel::performSorting ()
 {
+    GROUPLISTWIDGET_TRACE_SCOPE("GroupModel::performSorting");
     GROUPLISTWIDGET_TRACE_ENTRY;
+    GROUPLISTWIDGET_STATS_PHASE(this, PhaseSorting);
     // go through all groups
     foreach (GroupSubModel * subm, groups_) {
         subm->performSorting ();
@@ -801,7 +1025,9 @@ void GroupModel::performSorting ()
  */
 void GroupModel::performUnsorting ()
 {
+    GROUPLISTWIDGET_TRACE_SCOPE("GroupModel::performUnsorting");
     GROUPLISTWIDGET_TRACE_ENTRY;
+    GROUPLISTWIDGET_STATS_PHASE(this, PhaseSorting);
     // go through all groups
     foreach (GroupSubModel * subm, groups_) {
         subm->performUnsorting ();
@@ -898,6 +1124,7 @@ QStringList GroupModel::groupingColumnLabels (int * idx_crt) const
 void GroupModel::resetAllSubGroups ()
 {
     GROUPLISTWIDGET_TRACE_ENTRY;
+    item_cache_.clear ();
     foreach (GroupSubModel * subm, groups_) {
         subm->signalReset ();
     }
@@ -909,9 +1136,10 @@ void GroupModel::resetAllSubGroups ()
 ModelId GroupModel::label (int idx) const
 {
     int idx_max = additional_labels_.length ();
-    if ((idx < 0) || (idx > additional_labels_.length ())) {
-        GROUPLISTWIDGET_DEBUGM(
-                    "Label index %d outside valid range [0; %d).\n",
+    if ((idx < 0) || (idx >= idx_max)) {
+        GROUPLISTWIDGET_LOG_WARNING(
+                    grpLogModel,
+                    "Label index %d outside valid range [0; %d).",
                     idx, idx_max);
         return ModelId ();
     } else {
@@ -923,17 +1151,27 @@ ModelId GroupModel::label (int idx) const
 /* ------------------------------------------------------------------------- */
 void GroupModel::regroup ()
 {
-    if (!supress_signals_)
+    GROUPLISTWIDGET_TRACE_SCOPE("GroupModel::regroup");
+    GROUPLISTWIDGET_STATS_OPERATION(this, "regroup");
+    if (!supress_signals_) {
+        GROUPLISTWIDGET_STATS_PHASE(this, PhaseSignals);
         emit modelAboutToBeReset ();
+    }
     clearAllGroups();
+    item_cache_.clear ();
     if (baseModel () != NULL) {
         if (group_.column () != -1)
             buildAllGroups ();
         else
             buildNoGroupingGroup ();
     }
-    if (!supress_signals_)
+    if (!supress_signals_) {
+        GROUPLISTWIDGET_TRACE_SCOPE("modelReset");
+        GROUPLISTWIDGET_STATS_PHASE(this, PhaseSignals);
+        GROUPLISTWIDGET_STATS_COUNT(this, CountResets, 1);
         emit modelReset ();
+        emit operationPerformed (OpRegroup, 0);
+    }
 }
 /* ========================================================================= */
 
@@ -1058,13 +1296,17 @@ GroupModel::ComparisonReslt GroupModel::defaultCompare (
             return Equal;
         }
         default: {
-            GROUPLISTWIDGET_DEBUGM("Cannot compare %s (not supported)\n",
-                                   v1.typeName ());
+            GROUPLISTWIDGET_LOG_WARNING(
+                        grpLogCompare,
+                        "Cannot compare %s (not supported)",
+                        v1.typeName ());
             break;}
         }
     } else {
-        GROUPLISTWIDGET_DEBUGM("Cannot compare %s with %s\n",
-                               v1.typeName (), v2.typeName ());
+        GROUPLISTWIDGET_LOG_WARNING(
+                    grpLogCompare,
+                    "Cannot compare %s with %s",
+                    v1.typeName (), v2.typeName ());
     }
     Q_ASSERT(false);
     GROUPLISTWIDGET_TRACE_EXIT;
@@ -1072,4 +1314,110 @@ GroupModel::ComparisonReslt GroupModel::defaultCompare (
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+void GroupModel::statsBegin (const char * operation)
+{
+    if (stats_depth_++ > 0)
+        return;
+    stats_.clear ();
+    stats_.operation_ = QLatin1String (operation);
+    stats_timer_.start ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupModel::statsEnd ()
+{
+    Q_ASSERT (stats_depth_ > 0);
+    if (--stats_depth_ > 0)
+        return;
+    stats_.total_ns_ = stats_timer_.nsecsElapsed ();
+    last_stats_ = stats_;
+    emit statsReady (last_stats_);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QString GroupModel::operationName (int operation)
+{
+    switch (operation) {
+    case OpGroupingColumn: return QLatin1String ("groupingColumn");
+    case OpGroupingDirection: return QLatin1String ("groupingDirection");
+    case OpSortingColumn: return QLatin1String ("sortingColumn");
+    case OpSortingDirection: return QLatin1String ("sortingDirection");
+    case OpRegroup: return QLatin1String ("regroup");
+    case OpGroupingRole: return QLatin1String ("groupingRole");
+    case OpGroupLabelRole: return QLatin1String ("groupLabelRole");
+    case OpSortingRole: return QLatin1String ("sortingRole");
+    case OpPixmapColumn: return QLatin1String ("pixmapColumn");
+    case OpPixmapRole: return QLatin1String ("pixmapRole");
+    default: return QString ("operation%1").arg (operation);
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The base model is not included. Reading the item cache marks
+ * all its entries as recently used.
+ */
+GroupMemoryUsage GroupModel::memoryUsage () const
+{
+    GroupMemoryUsage result;
+    result.add (GroupMemoryUsage::PartGroups,
+                GroupMemoryUsage::listBytes (groups_.count ()) +
+                groups_.count () * sizeof (GroupSubModel),
+                groups_.count ());
+    foreach (const GroupSubModel * subm, groups_) {
+        result.add (GroupMemoryUsage::PartMappings,
+                    GroupMemoryUsage::listBytes (subm->mapping ().count ()),
+                    subm->mapping ().count ());
+        result.add (GroupMemoryUsage::PartKeys,
+                    GroupMemoryUsage::variantBytes (subm->groupKey ()));
+        result.add (GroupMemoryUsage::PartLabels,
+                    GroupMemoryUsage::stringBytes (subm->label ()));
+    }
+    result.add (GroupMemoryUsage::PartLabels,
+                GroupMemoryUsage::listBytes (additional_labels_.count ()) +
+                additional_labels_.count () * sizeof (ModelId),
+                additional_labels_.count ());
+
+    result.add (GroupMemoryUsage::PartRowIndex,
+                GroupMemoryUsage::vectorBytes (
+                    row_group_.capacity (), sizeof (int)) +
+                GroupMemoryUsage::vectorBytes (
+                    row_pos_.capacity (), sizeof (int)),
+                row_group_.count ());
+
+    // the entries account their size, as reading them would change
+    // the order in which they are evicted
+    result.add (GroupMemoryUsage::PartItemCache,
+                item_cache_bytes_, item_cache_.count ());
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The size is added to @p total here and subtracted when QCache deletes
+ * the entry, so the sum follows insertions, removals and evictions.
+ */
+GroupItemCacheEntry::GroupItemCacheEntry (
+        const GroupItemData & data, qint64 * total) :
+    data_(data),
+    bytes_(0),
+    total_(total)
+{
+    bytes_ = GroupMemoryUsage::cacheNodeBytes () +
+            sizeof (GroupItemCacheEntry) +
+            GroupMemoryUsage::variantBytes (data_.pixmap_) +
+            GroupMemoryUsage::listBytes (data_.labels_.count ()) +
+            data_.labels_.count () * sizeof (QVariant);
+    foreach (const QVariant & v, data_.labels_) {
+        bytes_ += GroupMemoryUsage::variantBytes (v);
+    }
+    *total_ += bytes_;
+}
+/* ========================================================================= */
+
 void GroupModel::anchorVtable () const {}
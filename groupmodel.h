@@ -14,6 +14,10 @@
 #include <QList>
 #include <QObject>
 #include <QVector>
+#include <QCache>
+#include <QElapsedTimer>
+#include <grouplistwidget/groupmodelstats.h>
+#include <grouplistwidget/groupmemoryusage.h>
 
 QT_BEGIN_NAMESPACE
 class QAbstractItemModel;
@@ -33,6 +37,27 @@ public:
     void setRole (Qt::ItemDataRole value) { second = value; }
 };
 
+//! All the values presented for an item, retrieved in a single pass.
+class GroupItemData {
+public:
+    GroupItemData () : base_row_(-1), pixmap_(), labels_() {}
+    int base_row_; /**< the row in base model (-1 if invalid) */
+    QVariant pixmap_; /**< the value for the icon */
+    QVariantList labels_; /**< the values for all labels, in order */
+};
+
+//! An entry of the cache kept by GroupModel::itemData() that accounts its memory.
+class GroupItemCacheEntry {
+public:
+    GroupItemCacheEntry (const GroupItemData & data, qint64 * total);
+    ~GroupItemCacheEntry () { *total_ -= bytes_; }
+    GroupItemData data_; /**< the cached values */
+    qint64 bytes_; /**< memory used by this entry */
+    qint64 * total_; /**< the sum kept by the model */
+private:
+    Q_DISABLE_COPY(GroupItemCacheEntry)
+};
+
 //! A model that is to be installed into a GroupListWidget.
 class GROUPLISTWIDGET_EXPORT GroupModel : public QObject {
     Q_OBJECT
@@ -48,6 +73,20 @@ public:
         Larger = 1
     };
 
+    //! Public operations reported by operationPerformed().
+    enum Operation {
+        OpGroupingColumn = 0,
+        OpGroupingDirection,
+        OpSortingColumn,
+        OpSortingDirection,
+        OpRegroup,
+        OpGroupingRole,
+        OpGroupLabelRole,
+        OpSortingRole,
+        OpPixmapColumn,
+        OpPixmapRole
+    };
+
     //! Compare two QVariants.
     typedef ComparisonReslt (*Compare) (
             GroupModel * model,
@@ -105,6 +144,30 @@ public:
     pixmap (
             int row) const;
 
+    //! Retrieve the pixmap and all labels for a row in base model.
+    GroupItemData
+    itemData (
+            int base_row) const;
+
+    //! Maximum number of rows kept by itemData().
+    int
+    itemCacheSize () const {
+        return item_cache_.maxCost ();
+    }
+
+    //! Change the maximum number of rows kept by itemData().
+    void
+    setItemCacheSize (
+            int value) {
+        item_cache_.setMaxCost (value);
+    }
+
+    //! Forget the values retrieved by itemData().
+    void
+    clearItemCache () {
+        item_cache_.clear ();
+    }
+
 
     //! Sets some opaque data useful for the user.
     virtual void
@@ -201,6 +264,7 @@ public:
             const ModelId & value) {
         additional_labels_.append (value);
         resetAllSubGroups ();
+        emit labelsChanged ();
     }
 
     //! Add the column and role for a label to be presented to the user.
@@ -223,6 +287,7 @@ public:
         Q_ASSERT(additional_labels_.length () > 0);
         additional_labels_[0] = value;
         resetAllSubGroups ();
+        emit labelsChanged ();
     }
 
     //! Set the column and role for a label.
@@ -235,6 +300,7 @@ public:
         } else {
             additional_labels_[idx] = value;
             resetAllSubGroups ();
+            emit labelsChanged ();
         }
     }
 
@@ -253,6 +319,12 @@ public:
             int item,
             int pos = 0) const;
 
+signals:
+
+    //! The list of labels or the column and role for a label changed.
+    void
+    labelsChanged ();
+
     ///@}
     /*  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  */
 
@@ -266,12 +338,18 @@ public:
 
 public:
 
-    //! Find the group that hosts a base model row; this is slow.
+    //! Find the group that hosts a base model row.
     GroupSubModel *
     groupForRow (
             int base_row,
             int * index_in_group = NULL);
 
+    //! Tell the model that the rows in groups changed.
+    void
+    invalidateRowIndex () {
+        row_index_dirty_ = true;
+    }
+
     //! Retrieve the column in base model that decides grouping.
     virtual int
     groupingColumn () const {
@@ -289,6 +367,8 @@ public:
     setGroupingRole (
             Qt::ItemDataRole role) {
         group_.setRole (role);
+        if (!supress_signals_)
+            emit operationPerformed (OpGroupingRole, role);
     }
 
     //! Retrieve the role in base model that decides grouping.
@@ -302,6 +382,8 @@ public:
     setGroupLabelRole (
             Qt::ItemDataRole role) {
         group_label_role_ = role;
+        if (!supress_signals_)
+            emit operationPerformed (OpGroupLabelRole, role);
     }
 
     //! Retrieve the role in base model that provides group label.
@@ -376,8 +458,10 @@ public slots:
     setGroupingDirection (
             Qt::SortOrder value) {
         group_dir_ = value;
-        if (!supress_signals_)
+        if (!supress_signals_) {
             emit groupingChanged (group_.column(), group_dir_);
+            emit operationPerformed (OpGroupingDirection, value);
+        }
     }
 
     //! Sets the direction of grouping.
@@ -445,8 +529,10 @@ public:
     setSortingRole (
             Qt::ItemDataRole role) {
         sort_.setRole (role);
-        if (!supress_signals_)
+        if (!supress_signals_) {
             emit sortingChanged (sort_.column(), sort_dir_);
+            emit operationPerformed (OpSortingRole, role);
+        }
     }
 
     //! Retrieve the role in base model that decides sorting.
@@ -548,6 +634,76 @@ signals:
     /*  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  */
 
 
+
+    /*  &&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&& */
+    /** @name Statistics
+     * Timings and counters for grouping and sorting operations
+     * (collected only when built with GROUPLISTWIDGET_STATS), estimated
+     * memory usage and notifications used by recorders.
+     */
+    ///@{
+
+public:
+
+    //! Estimated memory used by the groups, the row index and the item cache.
+    GroupMemoryUsage
+    memoryUsage () const;
+
+    //! The name of an Operation.
+    static QString
+    operationName (
+            int operation);
+
+    //! Timings and counters for the last operation.
+    const GroupModelStats &
+    lastStats () const {
+        return last_stats_;
+    }
+
+    //! Start an operation (nested ones are part of the outer one).
+    void
+    statsBegin (
+            const char * operation);
+
+    //! End an operation; the outermost one emits statsReady().
+    void
+    statsEnd ();
+
+    //! Add time to a phase of current operation.
+    void
+    statsAddTime (
+            GroupModelStats::Phase phase,
+            qint64 ns) {
+        if (stats_depth_ > 0)
+            stats_.phase_ns_[phase] += ns;
+    }
+
+    //! Increment a counter of current operation.
+    void
+    statsCount (
+            GroupModelStats::Counter counter,
+            qint64 n = 1) {
+        if (stats_depth_ > 0)
+            stats_.counter_[counter] += n;
+    }
+
+signals:
+
+    //! An operation ended and its statistics are available.
+    void
+    statsReady (
+            const GroupModelStats & stats);
+
+    //! A public operation that changes grouping or sorting was performed.
+    void
+    operationPerformed (
+            int operation,
+            int value);
+
+    ///@}
+    /*  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  */
+
+
 private slots:
 
     void
@@ -562,8 +718,15 @@ private slots:
             int first,
             int last);
 
+    void
+    baseModelStructureChange ();
+
 private:
 
+    //! Compute the group and position for each row in base model.
+    void
+    rebuildRowIndex () const;
+
     //! Install a base model inside this instance.
     void
     installBaseModel (
@@ -594,6 +757,18 @@ private:
 
     QList<ModelId> additional_labels_; /**< labels to be presented */
 
+    mutable qint64 item_cache_bytes_; /**< memory used by the entries in item_cache_ */
+    mutable QCache<int, GroupItemCacheEntry> item_cache_; /**< values retrieved by itemData() */
+
+    mutable QVector<int> row_group_; /**< index in groups_ for each base row */
+    mutable QVector<int> row_pos_; /**< index in the mapping of the group for each base row */
+    mutable bool row_index_dirty_; /**< row_group_ and row_pos_ need to be rebuilt */
+
+    GroupModelStats stats_; /**< values for the operation in progress */
+    GroupModelStats last_stats_; /**< values for the last operation */
+    int stats_depth_; /**< number of nested operations in progress */
+    QElapsedTimer stats_timer_; /**< started by outermost operation */
+
 public: virtual void anchorVtable() const;
 }; // class GroupModel
 
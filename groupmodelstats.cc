@@ -0,0 +1,118 @@
+/**
+ * @file groupmodelstats.cc
+ * @brief Definitions for GroupModelStats class.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#include "groupmodelstats.h"
+#include "groupmodel.h"
+#include "grouplistwidget-private.h"
+
+/**
+ * @class GroupModelStats
+ *
+ * The values are collected only when the library is built with
+ * GROUPLISTWIDGET_STATS defined; otherwise the macros that record them
+ * expand to nothing and all values stay zero.
+ *
+ * Nested operations (setBaseModel() building the groups,
+ * removeSorting() calling setSortingColumn()) are accounted to the
+ * outermost one. The slots connected to the signals of the model run
+ * inside the operation, so the rebuild of a GroupListWidget is part
+ * of the signals phase and is also reported on its own.
+ */
+
+/* ------------------------------------------------------------------------- */
+GroupModelStats::GroupModelStats () :
+    operation_(),
+    total_ns_(0)
+{
+    clear ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupModelStats::clear ()
+{
+    operation_.clear ();
+    total_ns_ = 0;
+    for (int i = 0; i < PhaseCount; ++i) {
+        phase_ns_[i] = 0;
+    }
+    for (int i = 0; i < CounterCount; ++i) {
+        counter_[i] = 0;
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+const char * GroupModelStats::phaseName (Phase value)
+{
+    switch (value) {
+    case PhaseKeys: return "keys";
+    case PhaseBucketing: return "bucketing";
+    case PhaseSorting: return "sorting";
+    case PhaseSignals: return "signals";
+    case PhaseRebuild: return "rebuild";
+    default: return "";
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+const char * GroupModelStats::counterName (Counter value)
+{
+    switch (value) {
+    case CountCompare: return "compare";
+    case CountData: return "data";
+    case CountGroupsCreated: return "groups_created";
+    case CountResets: return "resets";
+    default: return "";
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool GroupModelStats::isAvailable ()
+{
+#ifdef GROUPLISTWIDGET_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupStatsOperation::GroupStatsOperation (GroupModel * model, const char * name) :
+    m_(model)
+{
+    m_->statsBegin (name);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupStatsOperation::~GroupStatsOperation ()
+{
+    m_->statsEnd ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupStatsPhase::GroupStatsPhase (GroupModel * model, GroupModelStats::Phase phase) :
+    m_(model),
+    phase_(phase),
+    timer_()
+{
+    timer_.start ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupStatsPhase::~GroupStatsPhase ()
+{
+    m_->statsAddTime (phase_, timer_.nsecsElapsed ());
+}
+/* ========================================================================= */
@@ -0,0 +1,109 @@
+/**
+ * @file groupmodelstats.h
+ * @brief Declarations for GroupModelStats class
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#ifndef GUARD_GROUPMODELSTATS_H_INCLUDE
+#define GUARD_GROUPMODELSTATS_H_INCLUDE
+
+#include <grouplistwidget/grouplistwidget-config.h>
+#include <QString>
+#include <QElapsedTimer>
+#include <QMetaType>
+
+class GroupModel;
+
+//! Timings and counters collected while a GroupModel operation runs.
+class GROUPLISTWIDGET_EXPORT GroupModelStats {
+
+public:
+
+    //! The parts of an operation that are timed.
+    enum Phase {
+        PhaseKeys = 0, /**< reading the grouping keys from base model */
+        PhaseBucketing, /**< placing the rows into groups */
+        PhaseSorting, /**< sorting the rows inside groups */
+        PhaseSignals, /**< emitting the signals (includes connected slots) */
+        PhaseRebuild, /**< rebuilding the widget (part of PhaseSignals) */
+        PhaseCount
+    };
+
+    //! The events that are counted.
+    enum Counter {
+        CountCompare = 0, /**< calls to the comparison functions */
+        CountData, /**< calls to QModelIndex::data() on base model */
+        CountGroupsCreated, /**< groups that were created */
+        CountResets, /**< model resets that were emitted */
+        CounterCount
+    };
+
+    //! Default constructor.
+    GroupModelStats ();
+
+    //! Forget all values.
+    void
+    clear ();
+
+    //! Time spent in a phase (nanoseconds).
+    qint64
+    phase (
+            Phase value) const {
+        return phase_ns_[value];
+    }
+
+    //! The value of a counter.
+    qint64
+    counter (
+            Counter value) const {
+        return counter_[value];
+    }
+
+    //! Name of a phase.
+    static const char *
+    phaseName (
+            Phase value);
+
+    //! Name of a counter.
+    static const char *
+    counterName (
+            Counter value);
+
+    //! Is the library built with GROUPLISTWIDGET_STATS?
+    static bool
+    isAvailable ();
+
+    QString operation_; /**< the public method that was called */
+    qint64 total_ns_; /**< duration of the whole operation */
+    qint64 phase_ns_[PhaseCount]; /**< duration of each phase */
+    qint64 counter_[CounterCount]; /**< value of each counter */
+};
+Q_DECLARE_METATYPE(GroupModelStats)
+
+//! Marks the extent of an operation (used through GROUPLISTWIDGET_STATS_OPERATION).
+class GROUPLISTWIDGET_EXPORT GroupStatsOperation {
+public:
+    GroupStatsOperation (
+            GroupModel * model,
+            const char * name);
+    ~GroupStatsOperation ();
+private:
+    GroupModel * m_; /**< the model that collects the values */
+};
+
+//! Times a phase (used through GROUPLISTWIDGET_STATS_PHASE).
+class GROUPLISTWIDGET_EXPORT GroupStatsPhase {
+public:
+    GroupStatsPhase (
+            GroupModel * model,
+            GroupModelStats::Phase phase);
+    ~GroupStatsPhase ();
+private:
+    GroupModel * m_; /**< the model that collects the values */
+    GroupModelStats::Phase phase_; /**< the phase being timed */
+    QElapsedTimer timer_; /**< started by constructor */
+};
+
+#endif // GUARD_GROUPMODELSTATS_H_INCLUDE
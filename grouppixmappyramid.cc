@@ -0,0 +1,176 @@
+/**
+ * @file grouppixmappyramid.cc
+ * @brief Definitions for GroupPixmapPyramid class.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#include "grouppixmappyramid.h"
+#include "grouplistwidget-private.h"
+
+/**
+ * @class GroupPixmapPyramid
+ *
+ * Level 0 is the source image itself and is never stored. Level n is
+ * level n-1 scaled down by a factor of two, so all levels of an image
+ * take at most a third of the memory of the source. Levels are built
+ * lazily, only down to the one that is requested, and are shared
+ * by all the sizes that map to them.
+ *
+ * The images are identified by their cacheKey(), so a model that
+ * returns the same (implicitly shared) QPixmap each time benefits from
+ * the cache while a model that creates the images on the fly does not.
+ *
+ * The memory used by the levels is bounded by the budget(); least
+ * recently used images are dropped when the budget is exceeded.
+ */
+
+/* ------------------------------------------------------------------------- */
+//! The number of halvings that still leave the image larger than target.
+static int levelForTarget (const QSize & source, const QSize & target)
+{
+    if (source.isEmpty () || target.isEmpty ())
+        return 0;
+    int k = 0;
+    int w = source.width ();
+    int h = source.height ();
+    for (;;) {
+        int next_w = w / 2;
+        int next_h = h / 2;
+        if ((next_w < 1) || (next_h < 1))
+            break;
+        // the image is scaled to fit inside the target so it is enough
+        // for one of the dimensions to cover the target
+        if ((next_w < target.width ()) && (next_h < target.height ()))
+            break;
+        w = next_w;
+        h = next_h;
+        ++k;
+    }
+    return k;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+//! The amount of memory used by a list of levels in kilobytes.
+template <typename T>
+static int levelsCost (const QList<T> & levels)
+{
+    qint64 bytes = 0;
+    foreach (const T & lvl, levels) {
+        bytes += static_cast<qint64> (lvl.width ()) *
+                lvl.height () * lvl.depth () / 8;
+    }
+    return static_cast<int> (bytes / 1024) + 1;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+//! Common implementation for QPixmap and QImage sources.
+template <typename T>
+static T levelFromCache (
+        QCache<qint64, QList<T> > & cache, const T & source,
+        const QSize & target, int & hits, int & misses)
+{
+    int k = levelForTarget (source.size (), target);
+    if (k == 0)
+        return source;
+
+    qint64 key = source.cacheKey ();
+    QList<T> * levels = cache.object (key);
+    if ((levels != NULL) && (levels->count () >= k)) {
+        ++hits;
+        return levels->at (k - 1);
+    }
+    ++misses;
+
+    levels = cache.take (key);
+    if (levels == NULL)
+        levels = new QList<T> ();
+    while (levels->count () < k) {
+        const T & prev = levels->isEmpty () ? source : levels->last ();
+        levels->append (prev.scaled (
+                            prev.width () / 2, prev.height () / 2,
+                            Qt::IgnoreAspectRatio,
+                            Qt::SmoothTransformation));
+    }
+
+    // the cache may delete the list right away if it is over budget
+    T result = levels->at (k - 1);
+    cache.insert (key, levels, levelsCost (*levels));
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupPixmapPyramid::GroupPixmapPyramid (int budget_kb) :
+    pixmaps_(),
+    images_(),
+    hits_(0),
+    misses_(0)
+{
+    setBudget (budget_kb);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupPixmapPyramid::~GroupPixmapPyramid ()
+{
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param source the full size image
+ * @param target the size (in device pixels) of the area where the image
+ *               is going to be painted
+ * @return the source itself if it is less than two times larger than
+ *         the target, a downscaled version otherwise
+ */
+QPixmap GroupPixmapPyramid::level (
+        const QPixmap & source, const QSize & target)
+{
+    return levelFromCache (pixmaps_, source, target, hits_, misses_);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param source the full size image
+ * @param target the size (in device pixels) of the area where the image
+ *               is going to be painted
+ * @return the source itself if it is less than two times larger than
+ *         the target, a downscaled version otherwise
+ */
+QImage GroupPixmapPyramid::level (
+        const QImage & source, const QSize & target)
+{
+    return levelFromCache (images_, source, target, hits_, misses_);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The budget is split evenly between QPixmap and QImage sources.
+ *
+ * @param value new budget in kilobytes
+ */
+void GroupPixmapPyramid::setBudget (int value)
+{
+    if (value < 2)
+        value = 2;
+    pixmaps_.setMaxCost (value / 2);
+    images_.setMaxCost (value - value / 2);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupPixmapPyramid::clear ()
+{
+    pixmaps_.clear ();
+    images_.clear ();
+}
+/* ========================================================================= */
+
+void GroupPixmapPyramid::anchorVtable () const {}
@@ -0,0 +1,92 @@
+/**
+ * @file grouppixmappyramid.h
+ * @brief Declarations for GroupPixmapPyramid class
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+
+#ifndef GUARD_GROUP_PIXMAP_PYRAMID_H_INCLUDE
+#define GUARD_GROUP_PIXMAP_PYRAMID_H_INCLUDE
+
+#include <grouplistwidget/grouplistwidget-config.h>
+#include <QCache>
+#include <QList>
+#include <QPixmap>
+#include <QImage>
+#include <QSize>
+
+//! Keeps power-of-two downscaled versions of the images that are painted.
+class GROUPLISTWIDGET_EXPORT GroupPixmapPyramid {
+
+public:
+
+    //! Default constructor.
+    explicit GroupPixmapPyramid (
+            int budget_kb = 16 * 1024);
+
+    //! Destructor.
+    virtual ~GroupPixmapPyramid ();
+
+    //! Get the smallest level that is not smaller than the target size.
+    QPixmap
+    level (
+            const QPixmap & source,
+            const QSize & target);
+
+    //! Get the smallest level that is not smaller than the target size.
+    QImage
+    level (
+            const QImage & source,
+            const QSize & target);
+
+    //! The maximum amount of memory used by all levels (in kilobytes).
+    int
+    budget () const {
+        return pixmaps_.maxCost () + images_.maxCost ();
+    }
+
+    //! Change the maximum amount of memory used by all levels (in kilobytes).
+    void
+    setBudget (
+            int value);
+
+    //! Amount of memory currently used by all levels (in kilobytes).
+    int
+    usedKb () const {
+        return pixmaps_.totalCost () + images_.totalCost ();
+    }
+
+    //! Number of source images that have levels in the cache.
+    int
+    sourceCount () const {
+        return pixmaps_.count () + images_.count ();
+    }
+
+    //! Drop all levels.
+    void
+    clear ();
+
+    //! Number of requests served from existing levels.
+    int
+    hits () const {
+        return hits_;
+    }
+
+    //! Number of requests that had to build at least one level.
+    int
+    misses () const {
+        return misses_;
+    }
+
+private:
+    QCache<qint64, QList<QPixmap> > pixmaps_; /**< levels for QPixmap sources */
+    QCache<qint64, QList<QImage> > images_; /**< levels for QImage sources */
+    int hits_; /**< requests served from existing levels */
+    int misses_; /**< requests that had to build levels */
+
+public: virtual void anchorVtable() const;
+}; // class GroupPixmapPyramid
+
+#endif // GUARD_GROUP_PIXMAP_PYRAMID_H_INCLUDE
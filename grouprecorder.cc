@@ -0,0 +1,355 @@
+/**
+ * @file grouprecorder.cc
+ * @brief Definitions for GroupRecorder class.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#include "grouprecorder.h"
+#include "groupmodel.h"
+#include "grouplistwidget-private.h"
+
+#include <QAbstractItemModel>
+
+/**
+ * @class GroupRecorder
+ *
+ * The file starts with magic() and formatVersion() followed by records.
+ * Each record is a quint8 kind and a qint64 time in nanoseconds since
+ * start(), followed by:
+ * - RecSnapshot: a quint8 that is 1 if the model got a new base model,
+ *   the settings of the model (grouping, sorting, pixmap and labels),
+ *   the list of roles, the number of rows and columns and the value
+ *   of each role for each cell, row by row;
+ * - RecDataChanged: first and last row, first and last column and the
+ *   new values of the cells in that rectangle;
+ * - RecRowsInserted: first and last row and the values of the new rows;
+ * - RecRowsRemoved: first and last row;
+ * - RecOperation: a GroupModel::Operation and its value;
+ * - RecSettings: the settings and the roles as in a snapshot, then a
+ *   quint8 that is 1 if the roles changed, followed in that case by the
+ *   number of rows and columns and the cells saved with the new roles.
+ *
+ * Label changes and the role and pixmap setters of the model are saved
+ * as settings records.
+ *
+ * Moves, layout changes, resets and column changes in base model
+ * are saved as snapshots. Only flat (table and list) base models are
+ * supported and the values must be streamable through QDataStream.
+ * The decoration role is not saved unless requested with
+ * setExtraRoles().
+ *
+ * GroupReplayer reads the files.
+ */
+
+/* ------------------------------------------------------------------------- */
+GroupRecorder::GroupRecorder (QObject * parent) :
+    QObject (parent),
+    m_(),
+    base_(),
+    file_(),
+    stream_(),
+    clock_(),
+    extra_roles_(),
+    roles_(),
+    record_count_(0)
+{
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupRecorder::~GroupRecorder ()
+{
+    stop ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @return false if the file cannot be created or there is no model
+ */
+bool GroupRecorder::start (GroupModel * model, const QString & path)
+{
+    stop ();
+    if (model == NULL)
+        return false;
+
+    file_.setFileName (path);
+    if (!file_.open (QIODevice::WriteOnly | QIODevice::Truncate)) {
+        GROUPLISTWIDGET_LOG_WARNING(
+                    grpLogModel,
+                    "Cannot record to %s",
+                    qPrintable (path));
+        return false;
+    }
+    stream_.setDevice (&file_);
+    stream_.setVersion (QDataStream::Qt_5_0);
+    stream_ << magic () << formatVersion ();
+
+    m_ = model;
+    base_ = model->baseModel ();
+    record_count_ = 0;
+    clock_.start ();
+
+    connect (model, &GroupModel::modelReset,
+             this, &GroupRecorder::modelReset);
+    connect (model, &GroupModel::operationPerformed,
+             this, &GroupRecorder::modelOperation);
+    connect (model, &GroupModel::labelsChanged,
+             this, &GroupRecorder::settingsChanged);
+    connect (model, &QObject::destroyed,
+             this, &GroupRecorder::stop);
+    attachBase ();
+    beginRecord (RecSnapshot);
+    stream_ << quint8 (1);
+    writeSnapshot ();
+    return true;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupRecorder::stop ()
+{
+    if (!file_.isOpen ())
+        return;
+    detachBase ();
+    if (!m_.isNull ())
+        disconnect (m_.data (), NULL, this, NULL);
+    m_.clear ();
+    stream_.setDevice (NULL);
+    file_.close ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupRecorder::attachBase ()
+{
+    QAbstractItemModel * b = base_.data ();
+    if (b == NULL)
+        return;
+    connect (b, &QAbstractItemModel::dataChanged,
+             this, &GroupRecorder::baseDataChanged);
+    connect (b, &QAbstractItemModel::rowsInserted,
+             this, &GroupRecorder::baseRowsInserted);
+    connect (b, &QAbstractItemModel::rowsRemoved,
+             this, &GroupRecorder::baseRowsRemoved);
+    connect (b, &QAbstractItemModel::rowsMoved,
+             this, &GroupRecorder::baseStructureChanged);
+    connect (b, &QAbstractItemModel::columnsInserted,
+             this, &GroupRecorder::baseStructureChanged);
+    connect (b, &QAbstractItemModel::columnsRemoved,
+             this, &GroupRecorder::baseStructureChanged);
+    connect (b, &QAbstractItemModel::columnsMoved,
+             this, &GroupRecorder::baseStructureChanged);
+    connect (b, &QAbstractItemModel::layoutChanged,
+             this, &GroupRecorder::baseStructureChanged);
+    connect (b, &QAbstractItemModel::modelReset,
+             this, &GroupRecorder::baseStructureChanged);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupRecorder::detachBase ()
+{
+    if (!base_.isNull ())
+        disconnect (base_.data (), NULL, this, NULL);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupRecorder::beginRecord (Record kind)
+{
+    stream_ << quint8 (kind) << qint64 (clock_.nsecsElapsed ());
+    ++record_count_;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupRecorder::writeSnapshot ()
+{
+    writeSettings ();
+    writeContent ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupRecorder::writeSettings ()
+{
+    GroupModel * m = m_.data ();
+
+    // the roles used by the model and the ones requested by the user
+    roles_.clear ();
+    QList<int> wanted;
+    wanted << Qt::DisplayRole << Qt::EditRole
+           << m->groupingRole () << m->groupLabelRole () << m->sortingRole ();
+    for (int i = 0; i < m->labelCount (); ++i) {
+        wanted << m->label (i).role ();
+    }
+    foreach (int role, wanted) {
+        if ((role != Qt::DecorationRole) && !roles_.contains (role))
+            roles_.append (role);
+    }
+    foreach (int role, extra_roles_) {
+        if (!roles_.contains (role))
+            roles_.append (role);
+    }
+
+    stream_ << qint32 (m->groupingColumn ())
+            << qint32 (m->groupingRole ())
+            << qint32 (m->groupingDirection ())
+            << qint32 (m->groupLabelRole ())
+            << qint32 (m->sortingColumn ())
+            << qint32 (m->sortingRole ())
+            << qint32 (m->sortingDirection ())
+            << qint32 (m->pixmapColumn ())
+            << qint32 (m->pixmapRole ());
+    stream_ << qint32 (m->labelCount ());
+    for (int i = 0; i < m->labelCount (); ++i) {
+        ModelId mid = m->label (i);
+        stream_ << qint32 (mid.column ()) << qint32 (mid.role ());
+    }
+    stream_ << roles_;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupRecorder::writeContent ()
+{
+    QAbstractItemModel * b = base_.data ();
+    int rows = b == NULL ? 0 : b->rowCount ();
+    int cols = b == NULL ? 0 : b->columnCount ();
+    stream_ << qint32 (rows) << qint32 (cols);
+    if ((rows > 0) && (cols > 0))
+        writeCells (0, rows - 1, 0, cols - 1);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupRecorder::writeCells (
+        int first_row, int last_row, int first_col, int last_col)
+{
+    QAbstractItemModel * b = base_.data ();
+    for (int r = first_row; r <= last_row; ++r) {
+        for (int c = first_col; c <= last_col; ++c) {
+            QModelIndex idx = b->index (r, c);
+            foreach (int role, roles_) {
+                stream_ << idx.data (role);
+            }
+        }
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupRecorder::baseDataChanged (
+        const QModelIndex & top_left, const QModelIndex & bottom_right)
+{
+    int first_row = qMin (top_left.row (), bottom_right.row ());
+    int last_row = qMax (top_left.row (), bottom_right.row ());
+    int first_col = qMin (top_left.column (), bottom_right.column ());
+    int last_col = qMax (top_left.column (), bottom_right.column ());
+    beginRecord (RecDataChanged);
+    stream_ << qint32 (first_row) << qint32 (last_row)
+            << qint32 (first_col) << qint32 (last_col);
+    writeCells (first_row, last_row, first_col, last_col);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupRecorder::baseRowsInserted (
+        const QModelIndex & parent, int first, int last)
+{
+    if (parent.isValid ())
+        return;
+    beginRecord (RecRowsInserted);
+    stream_ << qint32 (first) << qint32 (last);
+    int cols = base_->columnCount ();
+    if (cols > 0)
+        writeCells (first, last, 0, cols - 1);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupRecorder::baseRowsRemoved (
+        const QModelIndex & parent, int first, int last)
+{
+    if (parent.isValid ())
+        return;
+    beginRecord (RecRowsRemoved);
+    stream_ << qint32 (first) << qint32 (last);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupRecorder::baseStructureChanged ()
+{
+    if (m_.isNull ())
+        return;
+    beginRecord (RecSnapshot);
+    stream_ << quint8 (0);
+    writeSnapshot ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The model also forwards the resets of base model; only a change of
+ * base model needs a new snapshot here.
+ */
+void GroupRecorder::modelReset ()
+{
+    if (m_.isNull () || (m_->baseModel () == base_.data ()))
+        return;
+    detachBase ();
+    base_ = m_->baseModel ();
+    attachBase ();
+    beginRecord (RecSnapshot);
+    stream_ << quint8 (1);
+    writeSnapshot ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The changes of roles and of the pixmap are saved as settings records,
+ * as they may change the roles that need to be saved for each cell.
+ */
+void GroupRecorder::modelOperation (int operation, int value)
+{
+    switch (operation) {
+    case GroupModel::OpGroupingRole:
+    case GroupModel::OpGroupLabelRole:
+    case GroupModel::OpSortingRole:
+    case GroupModel::OpPixmapColumn:
+    case GroupModel::OpPixmapRole:
+        settingsChanged ();
+        return;
+    default:
+        break;
+    }
+    beginRecord (RecOperation);
+    stream_ << qint32 (operation) << qint32 (value);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The cells are saved again only if the roles saved for each cell
+ * changed; the values of base model are the same.
+ */
+void GroupRecorder::settingsChanged ()
+{
+    if (m_.isNull ())
+        return;
+    QVector<int> prev_roles = roles_;
+    beginRecord (RecSettings);
+    writeSettings ();
+    bool b_content = roles_ != prev_roles;
+    stream_ << quint8 (b_content ? 1 : 0);
+    if (b_content)
+        writeContent ();
+}
+/* ========================================================================= */
+
+void GroupRecorder::anchorVtable () const {}
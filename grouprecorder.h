@@ -0,0 +1,178 @@
+/**
+ * @file grouprecorder.h
+ * @brief Declarations for GroupRecorder class
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#ifndef GUARD_GROUPRECORDER_H_INCLUDE
+#define GUARD_GROUPRECORDER_H_INCLUDE
+
+#include <grouplistwidget/grouplistwidget-config.h>
+#include <QObject>
+#include <QPointer>
+#include <QFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QModelIndex>
+#include <QVector>
+#include <QList>
+
+QT_BEGIN_NAMESPACE
+class QAbstractItemModel;
+QT_END_NAMESPACE
+
+class GroupModel;
+
+//! Writes the changes of a base model and the operations of a GroupModel to a file.
+class GROUPLISTWIDGET_EXPORT GroupRecorder : public QObject {
+    Q_OBJECT
+
+public:
+
+    //! The kinds of records in a file.
+    enum Record {
+        RecSnapshot = 0, /**< the full content of base model */
+        RecDataChanged, /**< new values for a range of cells */
+        RecRowsInserted, /**< new rows with their values */
+        RecRowsRemoved, /**< a range of rows was removed */
+        RecOperation, /**< a GroupModel::Operation and its value */
+        RecSettings /**< roles, pixmap and labels of the model changed */
+    };
+
+    //! Identifies the files.
+    static quint32
+    magic () {
+        return 0x474C5752; // GLWR
+    }
+
+    //! Version of the format.
+    static quint16
+    formatVersion () {
+        return 2;
+    }
+
+    //! Default constructor.
+    explicit GroupRecorder (
+            QObject * parent = NULL);
+
+    //! Destructor.
+    virtual ~GroupRecorder ();
+
+    //! Start recording a model into a file.
+    bool
+    start (
+            GroupModel * model,
+            const QString & path);
+
+    //! Stop recording and close the file.
+    void
+    stop ();
+
+    //! Is a recording in progress?
+    bool
+    isRecording () const {
+        return file_.isOpen ();
+    }
+
+    //! Number of records written so far.
+    int
+    recordCount () const {
+        return record_count_;
+    }
+
+    //! Roles saved for each cell in addition to the ones used by the model.
+    const QList<int> &
+    extraRoles () const {
+        return extra_roles_;
+    }
+
+    //! Change the roles saved for each cell; takes effect on next start().
+    void
+    setExtraRoles (
+            const QList<int> & value) {
+        extra_roles_ = value;
+    }
+
+private slots:
+
+    void
+    baseDataChanged (
+            const QModelIndex & top_left,
+            const QModelIndex & bottom_right);
+
+    void
+    baseRowsInserted (
+            const QModelIndex & parent,
+            int first,
+            int last);
+
+    void
+    baseRowsRemoved (
+            const QModelIndex & parent,
+            int first,
+            int last);
+
+    void
+    baseStructureChanged ();
+
+    void
+    modelReset ();
+
+    void
+    modelOperation (
+            int operation,
+            int value);
+
+    void
+    settingsChanged ();
+
+private:
+
+    //! Connect to the signals of base model.
+    void
+    attachBase ();
+
+    //! Disconnect from the signals of base model.
+    void
+    detachBase ();
+
+    //! Start a record.
+    void
+    beginRecord (
+            Record kind);
+
+    //! Write the roles, the settings of the model and all cells.
+    void
+    writeSnapshot ();
+
+    //! Write the settings of the model and the roles saved for each cell.
+    void
+    writeSettings ();
+
+    //! Write the size of base model and all cells.
+    void
+    writeContent ();
+
+    //! Write the values of a rectangle of cells.
+    void
+    writeCells (
+            int first_row,
+            int last_row,
+            int first_col,
+            int last_col);
+
+    QPointer<GroupModel> m_; /**< the model being recorded */
+    QPointer<QAbstractItemModel> base_; /**< base model being recorded */
+    QFile file_; /**< destination */
+    QDataStream stream_; /**< writes into file_ */
+    QElapsedTimer clock_; /**< time reference for the records */
+    QList<int> extra_roles_; /**< roles requested by the user */
+    QVector<int> roles_; /**< roles saved for each cell */
+    int record_count_; /**< records written so far */
+
+public: virtual void anchorVtable() const;
+}; // class GroupRecorder
+
+#endif // GUARD_GROUPRECORDER_H_INCLUDE
@@ -0,0 +1,518 @@
+/**
+ * @file groupreplayer.cc
+ * @brief Definitions for GroupReplayer class.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#include "groupreplayer.h"
+#include "grouprecorder.h"
+#include "groupmodel.h"
+#include "grouplistwidget-private.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QThread>
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @class GroupReplayModel
+ *
+ * Values are kept row by row; a row stores, for each column, the value
+ * of each of the roles that were recorded. Roles that were not recorded
+ * have no value.
+ */
+
+/* ------------------------------------------------------------------------- */
+GroupReplayModel::GroupReplayModel (QObject * parent) :
+    QAbstractTableModel (parent),
+    roles_(),
+    columns_(0),
+    rows_()
+{
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupReplayModel::~GroupReplayModel ()
+{
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupReplayModel::resetContent (
+        const QVector<int> & roles, int columns,
+        const QVector<QVector<QVariant> > & rows)
+{
+    beginResetModel ();
+    roles_ = roles;
+    columns_ = columns;
+    rows_ = rows;
+    endResetModel ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Used when the recorded model started using other roles; the values
+ * that views already saw did not change, so nothing is reported.
+ */
+void GroupReplayModel::replaceRoles (
+        const QVector<int> & roles,
+        const QVector<QVector<QVariant> > & rows)
+{
+    roles_ = roles;
+    rows_ = rows;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupReplayModel::setCells (
+        int first_row, int first_col, int last_col,
+        const QVector<QVector<QVariant> > & rows)
+{
+    int role_count = roles_.count ();
+    int i_max = rows.count ();
+    for (int i = 0; i < i_max; ++i) {
+        QVector<QVariant> & dest = rows_[first_row + i];
+        const QVector<QVariant> & src = rows.at (i);
+        int src_idx = 0;
+        for (int c = first_col; c <= last_col; ++c) {
+            for (int r = 0; r < role_count; ++r) {
+                dest[c * role_count + r] = src.at (src_idx++);
+            }
+        }
+    }
+    emit dataChanged (index (first_row, first_col),
+                      index (first_row + i_max - 1, last_col));
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupReplayModel::insertCells (
+        int first, const QVector<QVector<QVariant> > & rows)
+{
+    if (rows.isEmpty ())
+        return;
+    beginInsertRows (QModelIndex (), first, first + rows.count () - 1);
+    for (int i = 0; i < rows.count (); ++i) {
+        rows_.insert (first + i, rows.at (i));
+    }
+    endInsertRows ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupReplayModel::removeCells (int first, int last)
+{
+    beginRemoveRows (QModelIndex (), first, last);
+    rows_.remove (first, last - first + 1);
+    endRemoveRows ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int GroupReplayModel::rowCount (const QModelIndex & parent) const
+{
+    return parent.isValid () ? 0 : rows_.count ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int GroupReplayModel::columnCount (const QModelIndex & parent) const
+{
+    return parent.isValid () ? 0 : columns_;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QVariant GroupReplayModel::data (const QModelIndex & index, int role) const
+{
+    int r = roles_.indexOf (role);
+    if ((r == -1) || !index.isValid () || (index.row () >= rows_.count ()))
+        return QVariant ();
+    return rows_.at (index.row ()).value (
+                index.column () * roles_.count () + r);
+}
+/* ========================================================================= */
+
+void GroupReplayModel::anchorVtable () const {}
+
+
+/**
+ * @class GroupReplayer
+ *
+ * The file is loaded in memory by load(). run() installs a
+ * GroupReplayModel in the GroupModel when it finds a snapshot with a new
+ * base model and applies the rest of the records to that model or
+ * directly to the GroupModel (for operations). Each record is decoded
+ * before the clock is started, so the latencies only include the work
+ * done by the models (and by the views connected to them).
+ *
+ * In realtime mode run() waits between records so that the replay
+ * follows the times in the recording; the events of the application
+ * are processed while waiting.
+ */
+
+/* ------------------------------------------------------------------------- */
+//! Read the values for a rectangle of cells.
+static QVector<QVector<QVariant> > readCells (
+        QDataStream & stream, int rows, int cols, int roles)
+{
+    QVector<QVector<QVariant> > result;
+    if ((rows <= 0) || (cols <= 0))
+        return result;
+    result.reserve (rows);
+    int per_row = cols * roles;
+    for (int r = 0; r < rows; ++r) {
+        QVector<QVariant> row (per_row);
+        for (int i = 0; i < per_row; ++i) {
+            stream >> row[i];
+        }
+        if (stream.status () != QDataStream::Ok)
+            break;
+        result.append (row);
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupReplayer::GroupReplayer (QObject * parent) :
+    QObject (parent),
+    content_(),
+    record_count_(0),
+    duration_(0),
+    error_(),
+    base_(),
+    model_(),
+    names_(),
+    latencies_()
+{
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupReplayer::~GroupReplayer ()
+{
+    releaseBase ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The records are checked but not applied.
+ */
+bool GroupReplayer::load (const QString & path)
+{
+    content_.clear ();
+    record_count_ = 0;
+    duration_ = 0;
+    QFile file (path);
+    if (!file.open (QIODevice::ReadOnly)) {
+        error_ = QString ("cannot open %1").arg (path);
+        return false;
+    }
+    content_ = file.readAll ();
+    return parse (NULL, false);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Only the values that differ are changed, so the model does not see
+ * calls that were not made in the recorded session.
+ */
+static void applySettings (
+        GroupModel * model, const qint32 * settings,
+        const QList<ModelId> & labels)
+{
+    if (model->groupingRole () != settings[1])
+        model->setGroupingRole (Qt::ItemDataRole (settings[1]));
+    if (model->groupLabelRole () != settings[3])
+        model->setGroupLabelRole (Qt::ItemDataRole (settings[3]));
+    if (model->sortingRole () != settings[5])
+        model->setSortingRole (Qt::ItemDataRole (settings[5]));
+    if (model->pixmapColumn () != settings[7])
+        model->setPixmapColumn (settings[7]);
+    if (model->pixmapRole () != settings[8])
+        model->setPixmapRole (Qt::ItemDataRole (settings[8]));
+    for (int i = 0; i < labels.count (); ++i) {
+        const ModelId & mid = labels.at (i);
+        if (i >= model->labelCount ()) {
+            model->addLabel (mid);
+        } else if ((model->label (i).column () != mid.column ()) ||
+                   (model->label (i).role () != mid.role ())) {
+            model->setLabel (mid, i);
+        }
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The latencies from a previous run are discarded.
+ */
+bool GroupReplayer::run (GroupModel * model, bool realtime)
+{
+    if (model == NULL) {
+        error_ = QLatin1String ("no model");
+        return false;
+    }
+    names_.clear ();
+    latencies_.clear ();
+    return parse (model, realtime);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool GroupReplayer::parse (GroupModel * model, bool realtime)
+{
+    QDataStream stream (content_);
+    stream.setVersion (QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint16 version = 0;
+    stream >> magic >> version;
+    if ((magic != GroupRecorder::magic ()) ||
+            (version != GroupRecorder::formatVersion ())) {
+        error_ = QLatin1String ("not a recording or unsupported version");
+        return false;
+    }
+
+    QElapsedTimer wall;
+    wall.start ();
+    QElapsedTimer timer;
+    QVector<int> roles;
+    int columns = 0;
+    int count = 0;
+    while (!stream.atEnd ()) {
+        quint8 kind = 0;
+        qint64 ns = 0;
+        stream >> kind >> ns;
+
+        // decode the record
+        quint8 new_base = 0;
+        quint8 has_content = 0;
+        qint32 settings[9];
+        QList<ModelId> labels;
+        qint32 first = 0, last = 0, first_col = 0, last_col = 0;
+        qint32 operation = 0, value = 0;
+        QVector<QVector<QVariant> > cells;
+        QString name;
+        switch (kind) {
+        case GroupRecorder::RecSnapshot:
+        case GroupRecorder::RecSettings: {
+            if (kind == GroupRecorder::RecSnapshot)
+                stream >> new_base;
+            for (int i = 0; i < 9; ++i) {
+                stream >> settings[i];
+            }
+            qint32 label_count = 0;
+            stream >> label_count;
+            for (int i = 0; i < label_count; ++i) {
+                qint32 col, role;
+                stream >> col >> role;
+                labels.append (ModelId (col, Qt::ItemDataRole (role)));
+            }
+            stream >> roles;
+            if (kind == GroupRecorder::RecSettings) {
+                stream >> has_content;
+                name = QLatin1String ("settings");
+            } else {
+                has_content = 1;
+                name = QLatin1String ("snapshot");
+            }
+            if (has_content != 0) {
+                qint32 rows = 0, cols = 0;
+                stream >> rows >> cols;
+                columns = cols;
+                cells = readCells (stream, rows, cols, roles.count ());
+            }
+            break; }
+        case GroupRecorder::RecDataChanged: {
+            stream >> first >> last >> first_col >> last_col;
+            cells = readCells (stream, last - first + 1,
+                               last_col - first_col + 1, roles.count ());
+            name = QLatin1String ("dataChanged");
+            break; }
+        case GroupRecorder::RecRowsInserted: {
+            stream >> first >> last;
+            cells = readCells (stream, last - first + 1,
+                               columns, roles.count ());
+            name = QLatin1String ("rowsInserted");
+            break; }
+        case GroupRecorder::RecRowsRemoved: {
+            stream >> first >> last;
+            name = QLatin1String ("rowsRemoved");
+            break; }
+        case GroupRecorder::RecOperation: {
+            stream >> operation >> value;
+            name = GroupModel::operationName (operation);
+            break; }
+        default:
+            error_ = QString ("unknown record %1 at index %2")
+                    .arg (kind).arg (count);
+            return false;
+        }
+        if (stream.status () != QDataStream::Ok) {
+            error_ = QString ("truncated record at index %1").arg (count);
+            return false;
+        }
+        ++count;
+        duration_ = ns;
+        if (model == NULL)
+            continue;
+
+        if (realtime) {
+            for (;;) {
+                qint64 wait_ms = (ns - wall.nsecsElapsed ()) / 1000000;
+                if (wait_ms <= 0)
+                    break;
+                QCoreApplication::processEvents (
+                            QEventLoop::AllEvents, int (wait_ms));
+                if (wait_ms > 1)
+                    QThread::msleep (1);
+            }
+        }
+
+        // apply the record
+        switch (kind) {
+        case GroupRecorder::RecSnapshot: {
+            if ((new_base != 0) || base_.isNull ()) {
+                releaseBase ();
+                GroupReplayModel * rm = new GroupReplayModel ();
+                rm->resetContent (roles, columns, cells);
+                applySettings (model, settings, labels);
+                base_ = rm;
+                model_ = model;
+                timer.start ();
+                model->setBaseModel (
+                            rm, settings[0], settings[4],
+                            Qt::SortOrder (settings[2]),
+                            Qt::SortOrder (settings[6]));
+            } else {
+                timer.start ();
+                applySettings (model, settings, labels);
+                base_->resetContent (roles, columns, cells);
+            }
+            break; }
+        case GroupRecorder::RecSettings: {
+            timer.start ();
+            if ((has_content != 0) && !base_.isNull ())
+                base_->replaceRoles (roles, cells);
+            applySettings (model, settings, labels);
+            break; }
+        case GroupRecorder::RecDataChanged: {
+            timer.start ();
+            base_->setCells (first, first_col, last_col, cells);
+            break; }
+        case GroupRecorder::RecRowsInserted: {
+            timer.start ();
+            base_->insertCells (first, cells);
+            break; }
+        case GroupRecorder::RecRowsRemoved: {
+            timer.start ();
+            base_->removeCells (first, last);
+            break; }
+        case GroupRecorder::RecOperation: {
+            timer.start ();
+            switch (operation) {
+            case GroupModel::OpGroupingColumn:
+                model->setGroupingColumn (value);
+                break;
+            case GroupModel::OpGroupingDirection:
+                model->setGroupingDirection (Qt::SortOrder (value));
+                break;
+            case GroupModel::OpSortingColumn:
+                model->setSortingColumn (value);
+                break;
+            case GroupModel::OpSortingDirection:
+                model->setSortingDirection (Qt::SortOrder (value));
+                break;
+            case GroupModel::OpRegroup:
+                model->regroup ();
+                break;
+            default:
+                GROUPLISTWIDGET_LOG_WARNING(
+                            grpLogModel,
+                            "Unknown operation %d in recording",
+                            operation);
+            }
+            break; }
+        }
+        emit recordApplied (kind);
+        addLatency (name, timer.nsecsElapsed ());
+    }
+    record_count_ = count;
+    return true;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupReplayer::addLatency (const QString & name, qint64 ns)
+{
+    if (!latencies_.contains (name))
+        names_.append (name);
+    latencies_[name].append (ns);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * A GroupModel owns its base model and deletes it when it gets another
+ * one, so the model is only deleted here if it was taken out of the
+ * GroupModel or if that GroupModel is gone.
+ */
+void GroupReplayer::releaseBase ()
+{
+    if (base_.isNull ())
+        return;
+    if (!model_.isNull () && (model_->baseModel () == base_.data ()))
+        return;
+    delete base_.data ();
+    base_.clear ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Uses the nearest rank; returns 0 if there are no records of that kind.
+ */
+double GroupReplayer::percentile (const QString & name, double p) const
+{
+    QVector<qint64> values = latencies_.value (name);
+    if (values.isEmpty ())
+        return 0.0;
+    std::sort (values.begin (), values.end ());
+    int idx = qBound (0, int (std::ceil (p / 100.0 * values.count ())) - 1,
+                      values.count () - 1);
+    return values.at (idx) / 1.0e6;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QString GroupReplayer::report () const
+{
+    QString result = QString ("%1 %2 %3 %4 %5 %6\n")
+            .arg ("record", -18).arg ("count", 8)
+            .arg ("p50_ms", 10).arg ("p90_ms", 10)
+            .arg ("p99_ms", 10).arg ("max_ms", 10);
+    foreach (const QString & name, names_) {
+        result.append (QString ("%1 %2 %3 %4 %5 %6\n")
+                       .arg (name, -18)
+                       .arg (latencies_.value (name).count (), 8)
+                       .arg (percentile (name, 50), 10, 'f', 3)
+                       .arg (percentile (name, 90), 10, 'f', 3)
+                       .arg (percentile (name, 99), 10, 'f', 3)
+                       .arg (percentile (name, 100), 10, 'f', 3));
+    }
+    return result;
+}
+/* ========================================================================= */
+
+void GroupReplayer::anchorVtable () const {}
@@ -0,0 +1,195 @@
+/**
+ * @file groupreplayer.h
+ * @brief Declarations for GroupReplayer class
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#ifndef GUARD_GROUPREPLAYER_H_INCLUDE
+#define GUARD_GROUPREPLAYER_H_INCLUDE
+
+#include <grouplistwidget/grouplistwidget-config.h>
+#include <QAbstractTableModel>
+#include <QByteArray>
+#include <QMap>
+#include <QPointer>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+class GroupModel;
+
+//! A table model that holds the values saved by GroupRecorder.
+class GROUPLISTWIDGET_EXPORT GroupReplayModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+
+    //! Default constructor.
+    explicit GroupReplayModel (
+            QObject * parent = NULL);
+
+    //! Destructor.
+    virtual ~GroupReplayModel ();
+
+    //! Replace the whole content (emits a reset).
+    void
+    resetContent (
+            const QVector<int> & roles,
+            int columns,
+            const QVector<QVector<QVariant> > & rows);
+
+    //! Replace the roles and the values without signals (values of old roles are unchanged).
+    void
+    replaceRoles (
+            const QVector<int> & roles,
+            const QVector<QVector<QVariant> > & rows);
+
+    //! Change the values in a rectangle of cells.
+    void
+    setCells (
+            int first_row,
+            int first_col,
+            int last_col,
+            const QVector<QVector<QVariant> > & rows);
+
+    //! Insert rows before first.
+    void
+    insertCells (
+            int first,
+            const QVector<QVector<QVariant> > & rows);
+
+    //! Remove a range of rows.
+    void
+    removeCells (
+            int first,
+            int last);
+
+    virtual int
+    rowCount (
+            const QModelIndex & parent = QModelIndex()) const;
+
+    virtual int
+    columnCount (
+            const QModelIndex & parent = QModelIndex()) const;
+
+    virtual QVariant
+    data (
+            const QModelIndex & index,
+            int role = Qt::DisplayRole) const;
+
+private:
+
+    QVector<int> roles_; /**< the roles that were saved for each cell */
+    int columns_; /**< number of columns */
+    QVector<QVector<QVariant> > rows_; /**< columns_ * roles_ values per row */
+
+public: virtual void anchorVtable() const;
+}; // class GroupReplayModel
+
+
+//! Applies a file written by GroupRecorder to a GroupModel and times it.
+class GROUPLISTWIDGET_EXPORT GroupReplayer : public QObject {
+    Q_OBJECT
+
+public:
+
+    //! Default constructor.
+    explicit GroupReplayer (
+            QObject * parent = NULL);
+
+    //! Destructor.
+    virtual ~GroupReplayer ();
+
+    //! Read a file in memory.
+    bool
+    load (
+            const QString & path);
+
+    //! Number of records in the file that was loaded.
+    int
+    recordCount () const {
+        return record_count_;
+    }
+
+    //! Duration of the recording in nanoseconds.
+    qint64
+    duration () const {
+        return duration_;
+    }
+
+    //! Description of the last error.
+    const QString &
+    errorString () const {
+        return error_;
+    }
+
+    //! Apply all records to a model; the model gets a new base model.
+    bool
+    run (
+            GroupModel * model,
+            bool realtime = false);
+
+    //! The names of the kinds of records that were timed, in the order they were first seen.
+    const QStringList &
+    latencyNames () const {
+        return names_;
+    }
+
+    //! The time it took to apply each record of a kind, in nanoseconds.
+    QVector<qint64>
+    latencies (
+            const QString & name) const {
+        return latencies_.value (name);
+    }
+
+    //! A percentile (0 - 100) of the times for a kind of records, in milliseconds.
+    double
+    percentile (
+            const QString & name,
+            double p) const;
+
+    //! A table with the count, p50, p90, p99 and max for each kind of records.
+    QString
+    report () const;
+
+signals:
+
+    //! A record was applied; the time spent in connected slots is part of its latency.
+    void
+    recordApplied (
+            int kind);
+
+private:
+
+    //! Read the records and optionally apply them.
+    bool
+    parse (
+            GroupModel * model,
+            bool realtime);
+
+    //! Delete the base model of last run unless a model still uses it.
+    void
+    releaseBase ();
+
+    //! Remember the time of a record.
+    void
+    addLatency (
+            const QString & name,
+            qint64 ns);
+
+    QByteArray content_; /**< the file */
+    int record_count_; /**< records in the file */
+    qint64 duration_; /**< time of last record */
+    QString error_; /**< last error */
+    QPointer<GroupReplayModel> base_; /**< the model given to the GroupModel */
+    QPointer<GroupModel> model_; /**< the GroupModel that received base_ */
+    QStringList names_; /**< kinds of records in the order they were seen */
+    QMap<QString, QVector<qint64> > latencies_; /**< times by kind */
+
+public: virtual void anchorVtable() const;
+}; // class GroupReplayer
+
+#endif // GUARD_GROUPREPLAYER_H_INCLUDE
@@ -0,0 +1,205 @@
+/**
+ * @file groupselection.cc
+ * @brief Definitions for GroupSelection class.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#include "groupselection.h"
+#include "grouplistwidget-private.h"
+
+/**
+ * @class GroupSelection
+ *
+ * The selection is stored as one bit for each row in base model, so
+ * it does not depend on the way the rows are grouped and it survives
+ * regrouping, resorting and the lists being released.
+ *
+ * The rows outside valid range are ignored.
+ */
+
+/* ------------------------------------------------------------------------- */
+GroupSelection::GroupSelection (QObject * parent) :
+    QObject (parent),
+    bits_(),
+    count_(0),
+    serial_(0)
+{
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupSelection::~GroupSelection ()
+{
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupSelection::resize (int rows)
+{
+    if (rows < 0)
+        rows = 0;
+    if (rows == bits_.size ())
+        return;
+    bits_.resize (rows);
+    int prev_count = count_;
+    count_ = bits_.count (true);
+    if (prev_count != count_)
+        changed ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The bits are keyed by the row in base model, so they are moved to
+ * follow the records. The size grows by @p count rows even if it was
+ * already adjusted with resize().
+ */
+void GroupSelection::insertRows (int first, int count)
+{
+    if ((count <= 0) || (first < 0))
+        return;
+    int old_size = bits_.size ();
+    if (first > old_size)
+        first = old_size;
+    bits_.resize (old_size + count);
+    for (int i = old_size - 1; i >= first; --i) {
+        bits_.setBit (i + count, bits_.testBit (i));
+    }
+    bits_.fill (false, first, first + count);
+    if (count_ > 0)
+        changed ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupSelection::removeRows (int first, int count)
+{
+    int old_size = bits_.size ();
+    if ((first < 0) || (first >= old_size) || (count <= 0))
+        return;
+    count = qMin (count, old_size - first);
+    for (int i = first + count; i < old_size; ++i) {
+        bits_.setBit (i - count, bits_.testBit (i));
+    }
+    bits_.resize (old_size - count);
+    int prev_count = count_;
+    count_ = bits_.count (true);
+    if (prev_count > 0)
+        changed ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupSelection::changed ()
+{
+    ++serial_;
+    emit selectionChanged ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool GroupSelection::setBit (int row, bool value)
+{
+    if ((row < 0) || (row >= bits_.size ()))
+        return false;
+    if (bits_.testBit (row) == value)
+        return false;
+    bits_.setBit (row, value);
+    count_ += value ? 1 : -1;
+    return true;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupSelection::select (int row, bool value)
+{
+    if (setBit (row, value))
+        changed ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupSelection::selectRange (int first, int last, bool value)
+{
+    first = qMax (first, 0);
+    last = qMin (last, bits_.size () - 1);
+    if (first > last)
+        return;
+    bits_.fill (value, first, last + 1);
+    int prev_count = count_;
+    count_ = bits_.count (true);
+    if (prev_count != count_)
+        changed ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * A single selectionChanged() signal is emitted for all the rows.
+ */
+void GroupSelection::selectRows (const QList<int> & rows, bool value)
+{
+    bool b_changed = false;
+    foreach (int row, rows) {
+        b_changed |= setBit (row, value);
+    }
+    if (b_changed)
+        changed ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * A single selectionChanged() signal is emitted for all the rows.
+ */
+void GroupSelection::changeRows (
+        const QList<int> & selected, const QList<int> & deselected)
+{
+    bool b_changed = false;
+    foreach (int row, deselected) {
+        b_changed |= setBit (row, false);
+    }
+    foreach (int row, selected) {
+        b_changed |= setBit (row, true);
+    }
+    if (b_changed)
+        changed ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupSelection::toggle (int row)
+{
+    if (setBit (row, !isSelected (row)))
+        changed ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QList<int> GroupSelection::selectedRows () const
+{
+    QList<int> result;
+    result.reserve (count_);
+    int i_max = bits_.size ();
+    for (int i = 0; (i < i_max) && (result.count () < count_); ++i) {
+        if (bits_.testBit (i))
+            result.append (i);
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupSelection::clear ()
+{
+    if (count_ == 0)
+        return;
+    bits_.fill (false);
+    count_ = 0;
+    changed ();
+}
+/* ========================================================================= */
+
+void GroupSelection::anchorVtable () const {}
@@ -0,0 +1,137 @@
+/**
+ * @file groupselection.h
+ * @brief Declarations for GroupSelection class
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#ifndef GUARD_GROUPSELECTION_H_INCLUDE
+#define GUARD_GROUPSELECTION_H_INCLUDE
+
+#include <grouplistwidget/grouplistwidget-config.h>
+#include <QObject>
+#include <QBitArray>
+#include <QList>
+
+//! The selected rows of base model, shared by all groups.
+class GROUPLISTWIDGET_EXPORT GroupSelection : public QObject {
+    Q_OBJECT
+
+public:
+
+    //! Default constructor.
+    explicit GroupSelection (
+            QObject * parent = NULL);
+
+    //! Destructor.
+    virtual ~GroupSelection ();
+
+    //! Number of rows in base model.
+    int
+    rowCount () const {
+        return bits_.size ();
+    }
+
+    //! Change the number of rows; new rows are not selected.
+    void
+    resize (
+            int rows);
+
+    //! Rows were inserted in base model; the rows after them move down.
+    void
+    insertRows (
+            int first,
+            int count);
+
+    //! Rows were removed from base model; the rows after them move up.
+    void
+    removeRows (
+            int first,
+            int count);
+
+    //! Is a row selected?
+    bool
+    isSelected (
+            int row) const {
+        return (row >= 0) && (row < bits_.size ()) && bits_.testBit (row);
+    }
+
+    //! Number of selected rows.
+    int
+    count () const {
+        return count_;
+    }
+
+    //! Number of changes so far; compare two values to detect a change.
+    quint64
+    serial () const {
+        return serial_;
+    }
+
+    //! Select or deselect a row.
+    void
+    select (
+            int row,
+            bool value = true);
+
+    //! Select or deselect a range of rows (both ends included).
+    void
+    selectRange (
+            int first,
+            int last,
+            bool value = true);
+
+    //! Select or deselect a list of rows.
+    void
+    selectRows (
+            const QList<int> & rows,
+            bool value = true);
+
+    //! Select some rows and deselect others.
+    void
+    changeRows (
+            const QList<int> & selected,
+            const QList<int> & deselected);
+
+    //! Invert the state of a row.
+    void
+    toggle (
+            int row);
+
+    //! The selected rows in ascending order.
+    QList<int>
+    selectedRows () const;
+
+public slots:
+
+    //! Deselect all rows.
+    void
+    clear ();
+
+signals:
+
+    //! The set of selected rows changed.
+    void
+    selectionChanged ();
+
+private:
+
+    //! Account a change and tell the world about it.
+    void
+    changed ();
+
+    //! Change a bit and keep the count.
+    bool
+    setBit (
+            int row,
+            bool value);
+
+    QBitArray bits_; /**< one bit for each row in base model */
+    int count_; /**< number of bits that are set */
+    quint64 serial_; /**< incremented each time the selection changes */
+
+public: virtual void anchorVtable() const;
+}; // class GroupSelection
+
+#endif // GUARD_GROUPSELECTION_H_INCLUDE
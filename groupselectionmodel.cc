@@ -0,0 +1,156 @@
+/**
+ * @file groupselectionmodel.cc
+ * @brief Definitions for GroupSelectionModel class.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#include "groupselectionmodel.h"
+#include "groupselection.h"
+#include "groupsubmodel.h"
+#include "grouplistwidget-private.h"
+
+/**
+ * @class GroupSelectionModel
+ *
+ * Qt views need a QItemSelectionModel for their model; this one keeps
+ * no ranges of its own. The commands issued by the view are translated
+ * to rows in base model and applied to the GroupSelection shared by all
+ * the lists, so a Clear drops the selection in every group.
+ *
+ * As the ranges in the base class stay empty, isSelected() and
+ * selectedIndexes() of the base class always report nothing; use
+ * isRowSelected() and selectedRowIndexes() instead. No selectionChanged()
+ * signal is emitted; the views follow GroupSelection::selectionChanged().
+ */
+
+/* ------------------------------------------------------------------------- */
+GroupSelectionModel::GroupSelectionModel (
+        GroupSubModel * model, GroupSelection * selection, QObject * parent) :
+    QItemSelectionModel (model, parent),
+    selection_(selection),
+    current_on_(),
+    current_off_()
+{
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupSelectionModel::~GroupSelectionModel ()
+{
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool GroupSelectionModel::isRowSelected (int row) const
+{
+    const GroupSubModel * gsm =
+            qobject_cast<const GroupSubModel *>(model ());
+    if ((gsm == NULL) || selection_.isNull ())
+        return false;
+    return selection_->isSelected (gsm->mapRowToBaseModel (row));
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QModelIndexList GroupSelectionModel::selectedRowIndexes (int column) const
+{
+    QModelIndexList result;
+    const GroupSubModel * gsm =
+            qobject_cast<const GroupSubModel *>(model ());
+    if ((gsm == NULL) || selection_.isNull () || (selection_->count () == 0))
+        return result;
+    int i_max = gsm->rowCount ();
+    for (int i = 0; i < i_max; ++i) {
+        if (selection_->isSelected (gsm->mapRowToBaseModel (i)))
+            result.append (gsm->index (i, column));
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupSelectionModel::select (
+        const QModelIndex & index, QItemSelectionModel::SelectionFlags command)
+{
+    QItemSelection sel;
+    if (index.isValid ())
+        sel.select (index, index);
+    select (sel, command);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * A command with the Current flag replaces the effect of the previous
+ * one (the rubber band or the shift-extended range of the view); any
+ * other command makes the changes permanent.
+ */
+void GroupSelectionModel::select (
+        const QItemSelection & selection,
+        QItemSelectionModel::SelectionFlags command)
+{
+    const GroupSubModel * gsm =
+            qobject_cast<const GroupSubModel *>(model ());
+    if ((gsm == NULL) || selection_.isNull () ||
+            (command == QItemSelectionModel::NoUpdate))
+        return;
+
+    if ((command & QItemSelectionModel::Current) != 0) {
+        revertCurrent ();
+    } else {
+        current_on_.clear ();
+        current_off_.clear ();
+    }
+    if ((command & QItemSelectionModel::Clear) != 0) {
+        selection_->clear ();
+        current_on_.clear ();
+        current_off_.clear ();
+    }
+
+    QList<int> on;
+    QList<int> off;
+    foreach (const QItemSelectionRange & range, selection) {
+        if (range.model () != gsm)
+            continue;
+        for (int i = range.top (); i <= range.bottom (); ++i) {
+            int row = gsm->mapRowToBaseModel (i);
+            bool prev = selection_->isSelected (row);
+            bool value = prev;
+            if ((command & QItemSelectionModel::Select) != 0) {
+                value = true;
+            } else if ((command & QItemSelectionModel::Deselect) != 0) {
+                value = false;
+            } else if ((command & QItemSelectionModel::Toggle) != 0) {
+                value = !prev;
+            }
+            if (value == prev)
+                continue;
+            if (value)
+                on.append (row);
+            else
+                off.append (row);
+        }
+    }
+    selection_->changeRows (on, off);
+
+    if ((command & QItemSelectionModel::Current) != 0) {
+        current_on_ = on;
+        current_off_ = off;
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupSelectionModel::revertCurrent ()
+{
+    if (current_on_.isEmpty () && current_off_.isEmpty ())
+        return;
+    selection_->changeRows (current_off_, current_on_);
+    current_on_.clear ();
+    current_off_.clear ();
+}
+/* ========================================================================= */
+
+void GroupSelectionModel::anchorVtable () const {}
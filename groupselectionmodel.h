@@ -0,0 +1,76 @@
+/**
+ * @file groupselectionmodel.h
+ * @brief Declarations for GroupSelectionModel class
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#ifndef GUARD_GROUPSELECTIONMODEL_H_INCLUDE
+#define GUARD_GROUPSELECTIONMODEL_H_INCLUDE
+
+#include <grouplistwidget/grouplistwidget-config.h>
+#include <QItemSelectionModel>
+#include <QPointer>
+#include <QList>
+
+class GroupSelection;
+class GroupSubModel;
+
+//! Selection model of a list that stores the selection in a GroupSelection.
+class GROUPLISTWIDGET_EXPORT GroupSelectionModel : public QItemSelectionModel {
+    Q_OBJECT
+
+public:
+
+    //! Constructor.
+    GroupSelectionModel (
+            GroupSubModel * model,
+            GroupSelection * selection,
+            QObject * parent = NULL);
+
+    //! Destructor.
+    virtual ~GroupSelectionModel ();
+
+    //! The shared selection.
+    GroupSelection *
+    selection () const {
+        return selection_;
+    }
+
+    //! Is a row of the group selected?
+    bool
+    isRowSelected (
+            int row) const;
+
+    //! The selected indexes of the group in the given column.
+    QModelIndexList
+    selectedRowIndexes (
+            int column) const;
+
+    //! Change the selection for a single index.
+    virtual void
+    select (
+            const QModelIndex & index,
+            QItemSelectionModel::SelectionFlags command);
+
+    //! Change the selection for a set of ranges.
+    virtual void
+    select (
+            const QItemSelection & selection,
+            QItemSelectionModel::SelectionFlags command);
+
+private:
+
+    //! Undo the changes made by the last command with the Current flag.
+    void
+    revertCurrent ();
+
+    QPointer<GroupSelection> selection_; /**< where the selection is stored */
+    QList<int> current_on_; /**< base rows selected by the current command */
+    QList<int> current_off_; /**< base rows deselected by the current command */
+
+public: virtual void anchorVtable() const;
+}; // class GroupSelectionModel
+
+#endif // GUARD_GROUPSELECTIONMODEL_H_INCLUDE
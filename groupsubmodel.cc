@@ -15,6 +15,8 @@
 #include <QList>
 #include <QVariant>
 #include <QSize>
+#include <QVector>
+#include <algorithm>
 
 /**
  * @class GroupSubModel
@@ -61,6 +63,8 @@ GroupSubModel::~GroupSubModel()
 /* ------------------------------------------------------------------------- */
 /**
  * Makes sure that the inserted row is placed at appropriate index.
+ * Rows with equal values are kept in the order of their rows in base
+ * model, the same order that performSorting() produces.
  */
 void GroupSubModel::insertSortedRecord (int new_row)
 {
@@ -71,30 +75,30 @@ void GroupSubModel::insertSortedRecord (int new_row)
         // no sorting so we use original order
         // still, we have no guarantee that the rows arive in
         // increasing order
-        foreach (int rold, map_) {
-            if (rold > new_row) {
-                map_.insert (idx, new_row);
-                inserted = true;
-            }
-            ++idx;
-        }
+        map_.insert (std::upper_bound (map_.begin (), map_.end (), new_row),
+                     new_row);
+        inserted = true;
     } else {
         int sortr = m_->sortingRole ();
         GroupModel::Compare sort_func = m_->sortingFunc();
         QModelIndex midx_new = m_->baseModel()->index (new_row, sortc);
         QVariant new_data = midx_new.data (sortr);
+        GROUPLISTWIDGET_STATS_ONLY(qint64 compares = 0);
 
         foreach (int row, map_) {
             QModelIndex midx_iter = m_->baseModel()->index (row, sortc);
             QVariant iter_data = midx_iter.data (sortr);
+            GROUPLISTWIDGET_STATS_ONLY(++compares);
 
             GroupModel::ComparisonReslt res = sort_func (
                         m_, sortc, new_data, iter_data);
 
             switch (res) {
             case GroupModel::Equal: {
-                map_.insert (idx+1, new_row);
-                inserted = true;
+                if (row > new_row) {
+                    map_.insert (idx, new_row);
+                    inserted = true;
+                }
                 break; }
             case GroupModel::Smaller: {
                 map_.insert (idx, new_row);
@@ -107,13 +111,79 @@ void GroupSubModel::insertSortedRecord (int new_row)
                 break;
             ++idx;
         }
+        GROUPLISTWIDGET_STATS_COUNT(m_, CountCompare, compares);
+        GROUPLISTWIDGET_STATS_COUNT(m_, CountData, compares + 1);
     }
     if (!inserted) {
         map_.append (new_row);
     }
+    invalidateRowIndex ();
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+//! Orders positions in the mapping by the values of the sorting column.
+//!
+//! The comparison function only sees values of the same type (or null
+//! values); values of different types are ordered by their type and
+//! equal values by their row, so the result is a total order.
+class GrpSortByValue {
+public:
+    GrpSortByValue (GroupModel * m, int column,
+                 const QVariantList & values, const QList<int> & rows,
+                 qint64 * calls) :
+        m_(m), column_(column), values_(values), rows_(rows),
+        func_(m->sortingFunc())
+#ifdef GROUPLISTWIDGET_STATS
+        , calls_(calls)
+#endif
+    {
+        Q_UNUSED(calls);
+    }
+
+    bool operator() (int a, int b) const {
+        GROUPLISTWIDGET_STATS_ONLY(++*calls_);
+        const QVariant & va = values_.at (a);
+        const QVariant & vb = values_.at (b);
+        if (!va.isNull () && !vb.isNull () &&
+                (va.userType () != vb.userType ())) {
+            return va.userType () < vb.userType ();
+        }
+        GroupModel::ComparisonReslt res = func_ (m_, column_, va, vb);
+        if (res == GroupModel::Equal) {
+            // equal values ordered by row index
+            return rows_.at (a) < rows_.at (b);
+        }
+        return res == GroupModel::Smaller;
+    }
+
+private:
+    GroupModel * m_;
+    int column_;
+    const QVariantList & values_;
+    const QList<int> & rows_;
+    GroupModel::Compare func_;
+#ifdef GROUPLISTWIDGET_STATS
+    qint64 * calls_; /**< number of comparisons */
+#endif
+};
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+//! Orders positions in the mapping by the row in base model.
+class GrpSortByRow {
+public:
+    explicit GrpSortByRow (const QList<int> & rows) : rows_(rows) {}
+
+    bool operator() (int a, int b) const {
+        return rows_.at (a) < rows_.at (b);
+    }
+
+private:
+    const QList<int> & rows_;
+};
+/* ========================================================================= */
+
 /* ------------------------------------------------------------------------- */
 /**
  * Retrieves the values for all rows and, based on those, arranges the internal
@@ -129,7 +199,6 @@ void GroupSubModel::performSorting ()
     if (i_max == 0)
         return;
     int sortr = m_->sortingRole ();
-    beginResetModel();
 
     // create a list of values so that we don't retrieve them multiple times
     QVariantList vlst;
@@ -139,34 +208,16 @@ void GroupSubModel::performSorting ()
         vlst.append (midx.data (sortr));
     }
 
-
-    GroupModel::Compare sort_func = m_->sortingFunc();
-    for (int n = 0; n < i_max; n++) {
-        for (int i = n + 1; i < i_max; i++) {
-            const QVariant & nval = vlst.at (n);
-            const QVariant & ival = vlst.at (i);
-
-            GroupModel::ComparisonReslt res = sort_func (
-                        m_, sortc, nval, ival);
-            switch (res) {
-            case GroupModel::Equal: {
-                // equal values ordered by row index
-                if (map_.at (n) > map_.at (i)) {
-                    vlst.swap (n, i);
-                    map_.swap (n, i);
-                }
-                break; }
-            case GroupModel::Smaller: {
-                // ok
-                break; }
-            case GroupModel::Larger: {
-                vlst.swap (n, i);
-                map_.swap (n, i);
-                break; }
-            }
-        }
+    QVector<int> order (i_max);
+    for (int i = 0; i < i_max; ++i) {
+        order[i] = i;
     }
-    endResetModel();
+    qint64 compares = 0;
+    std::sort (order.begin(), order.end(),
+               GrpSortByValue (m_, sortc, vlst, map_, &compares));
+    GROUPLISTWIDGET_STATS_COUNT(m_, CountCompare, compares);
+    GROUPLISTWIDGET_STATS_COUNT(m_, CountData, i_max);
+    applyOrder (order);
 }
 /* ========================================================================= */
 
@@ -176,19 +227,60 @@ void GroupSubModel::performSorting ()
  */
 void GroupSubModel::performUnsorting()
 {
-    beginResetModel();
     int i_max = map_.count();
     if (i_max == 0)
         return;
 
-    for (int n = 0; n < i_max; n++) {
-        for (int i = n + 1; i < i_max; i++) {
-            if (map_.at (n) > map_.at (i)) {
-                map_.swap (n, i);
-            }
-        }
+    QVector<int> order (i_max);
+    for (int i = 0; i < i_max; ++i) {
+        order[i] = i;
     }
-    endResetModel();
+    std::sort (order.begin(), order.end(), GrpSortByRow (map_));
+    applyOrder (order);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The views are informed using layoutAboutToBeChanged() and layoutChanged()
+ * so they keep their selection, current item and scroll position.
+ * The persistent indexes are moved using the inverse of the
+ * permutation, computed in linear time.
+ *
+ * @param order for each new position in the mapping, the old position
+ */
+void GroupSubModel::applyOrder (const QVector<int> & order)
+{
+    int i_max = map_.count();
+    Q_ASSERT(order.count() == i_max);
+    bool b_asc = m_->sortingDirection() == Qt::AscendingOrder;
+
+    emit layoutAboutToBeChanged ();
+
+    // old position -> new position
+    QVector<int> inverse (i_max);
+    QList<int> new_map;
+    new_map.reserve (i_max);
+    for (int i = 0; i < i_max; ++i) {
+        inverse[order.at (i)] = i;
+        new_map.append (map_.at (order.at (i)));
+    }
+
+    // rows seen by the views depend on the direction of sorting
+    QModelIndexList from = persistentIndexList ();
+    QModelIndexList to;
+    to.reserve (from.count());
+    foreach (const QModelIndex & idx, from) {
+        int old_pos = b_asc ? idx.row() : i_max - idx.row() - 1;
+        int new_pos = inverse.at (old_pos);
+        to.append (index (b_asc ? new_pos : i_max - new_pos - 1,
+                          idx.column()));
+    }
+
+    map_ = new_map;
+    invalidateRowIndex ();
+    changePersistentIndexList (from, to);
+    emit layoutChanged ();
 }
 /* ========================================================================= */
 
@@ -205,8 +297,9 @@ QVariant GroupSubModel::data (const QModelIndex &index, int role) const
 {
     int r = index.row();
     if ((r < 0) || (r >= map_.count())) {
-        GROUPLISTWIDGET_DEBUGM(
-                    "GroupSubModel data requested for non-existing row %d\n",
+        GROUPLISTWIDGET_LOG_WARNING(
+                    grpLogModel,
+                    "GroupSubModel data requested for non-existing row %d",
                     index.row());
         return QVariant ();
     }
@@ -216,12 +309,11 @@ QVariant GroupSubModel::data (const QModelIndex &index, int role) const
     if (index.column() == 0) {
         if (role == Qt::DecorationRole) {
             // the icon
-            c = m_->pixmapColumn();
-            if (c == -1) {
+            if (m_->pixmapColumn() == -1) {
                 // all images are off
                 return QVariant();
             }
-            role = m_->pixmapRole();
+            return m_->itemData (r).pixmap_;
         } /*else if (role == Qt::SizeHintRole) {
             return QSize(60, 20);
         }*/ else if (role >= GroupModel::BaseColRole) {
@@ -229,10 +321,7 @@ QVariant GroupSubModel::data (const QModelIndex &index, int role) const
             if (c >= m_->labelCount ()) {
                 return QVariant();
             }
-
-            ModelId mid = m_->label (c);
-            c = mid.column ();
-            role = mid.role ();
+            return m_->itemData (r).labels_.value (c);
         }
     }
     return m_->baseModel()->index (r, c).data (role);
@@ -271,14 +360,32 @@ int GroupSubModel::mapRowToBaseModel (int row) const
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+/**
+ * All the values are retrieved in a single pass and are served from
+ * the cache in the parent model when possible.
+ *
+ * @param row a zero-based index in the list of items this model manages
+ * @return the values; base_row_ member is -1 if the \b row is outside valid range
+ */
+GroupItemData GroupSubModel::rowData (int row) const
+{
+    int r = mapRowToBaseModel (row);
+    if (r == -1)
+        return GroupItemData ();
+    return m_->itemData (r);
+}
+/* ========================================================================= */
+
 /* ------------------------------------------------------------------------- */
 bool GroupSubModel::removeRows (
         int row, int count, const QModelIndex & /*parent*/)
 {
     int last_row = row + count - 1;
     if (last_row >= map_.count()) {
-        GROUPLISTWIDGET_DEBUGM(
-                    "Last row %d is outside valid range [0..%d)\n",
+        GROUPLISTWIDGET_LOG_WARNING(
+                    grpLogModel,
+                    "Last row %d is outside valid range [0..%d)",
                     last_row,  map_.count());
         last_row = map_.count() - 1;
     }
@@ -287,6 +394,7 @@ bool GroupSubModel::removeRows (
     for (int riter = last_row; riter >= row ; --riter) {
         map_.removeAt (riter);
     }
+    invalidateRowIndex ();
    // endRemoveRows();
     signalReset ();
     return true;
@@ -296,10 +404,10 @@ bool GroupSubModel::removeRows (
 /* ------------------------------------------------------------------------- */
 int GroupSubModel::listIndex () const
 {
-    if (m_->sortingDirection() == Qt::AscendingOrder) {
+    if (m_->groupingDirection() == Qt::AscendingOrder) {
         return list_index_;
     } else {
-        return m_->groupCount() - list_index_;
+        return m_->groupCount() - list_index_ - 1;
     }
 }
 /* ========================================================================= */
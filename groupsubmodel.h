@@ -11,16 +11,16 @@
 
 #include <grouplistwidget/grouplistwidget-config.h>
 #include <QMap>
+#include <QVector>
 #include <QVariant>
 #include <QString>
 #include <QAbstractListModel>
+#include <grouplistwidget/groupmodel.h>
 
 QT_BEGIN_NAMESPACE
 class QAbstractItemModel;
 QT_END_NAMESPACE
 
-class GroupModel;
-
 //! A model representing a group that is used by the embedded lists.
 class GROUPLISTWIDGET_EXPORT GroupSubModel : public QAbstractListModel {
     Q_OBJECT
@@ -61,6 +61,7 @@ public:
     appendRecord (
             int original_row) {
         map_.append (original_row);
+        invalidateRowIndex ();
     }
 
     //! Insert a new record in the proper place.
@@ -127,6 +128,11 @@ public:
     mapRowToBaseModel (
             int row) const;
 
+    //! Retrieve the pixmap and all labels for a row in this model.
+    GroupItemData
+    rowData (
+            int row) const;
+
     //! Maps rows in this model to rows in base model.
     const QList<int> &
     mapping () const {
@@ -150,6 +156,18 @@ protected:
         list_index_ = value;
     }
 
+    //! Rearrange the rows and let the views know.
+    void
+    applyOrder (
+            const QVector<int> & order);
+
+    //! Let the parent know that the rows changed.
+    void
+    invalidateRowIndex () {
+        if (m_ != NULL)
+            m_->invalidateRowIndex ();
+    }
+
     //! Will emit dataChange for this row.
     void
     baseModelDataChange (
@@ -0,0 +1,308 @@
+/**
+ * @file grouptracer.cc
+ * @brief Definitions for GroupTracer class.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#include "grouptracer.h"
+#include "grouplistwidget-private.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QVector>
+
+/**
+ * @class GroupTracer
+ *
+ * Each thread that records an event gets its own ring buffer, so
+ * recording takes no lock: the thread writes the event and then
+ * publishes the new position. Only the first event of a thread takes
+ * a mutex to register the buffer. When the buffer is full the oldest
+ * events are overwritten.
+ *
+ * When a thread finishes its buffer is retired: the events are still
+ * exported, but the buffer is handed to the next thread that starts
+ * recording. The memory is thus bounded by the number of threads that
+ * record at the same time, even with thread pools or short lived threads.
+ *
+ * When recording is disabled a traced scope costs one load and one
+ * branch. Names must outlive the tracer (string literals), as only
+ * the pointer is stored.
+ *
+ * The writers never take the mutex, so clear() and toJson() can not
+ * stop them. For an exact result call setEnabled(false) and let the
+ * scopes that are still open finish before calling them. While other
+ * threads record toJson() copies each ring and drops the events that
+ * were overwritten meanwhile, and clear() only moves the start of the
+ * rings, so both stay safe but may miss events recorded concurrently.
+ * The result can be opened in chrome://tracing or in Perfetto.
+ */
+
+//! One recorded event.
+class GrpTraceEvent {
+public:
+    const char * name_; /**< name of the scope */
+    qint64 ts_ns_; /**< time since the tracer started */
+    char phase_; /**< 'B' for begin, 'E' for end */
+};
+
+//! The events recorded by one thread.
+class GrpTraceBuffer {
+public:
+    explicit GrpTraceBuffer (int capacity, int tid, const QString & thread_name) :
+        events_(capacity), head_(0), base_(0), tid_(tid),
+        thread_name_(thread_name), retired_(false)
+    {}
+    QVector<GrpTraceEvent> events_; /**< the ring */
+    QAtomicInteger<quint64> head_; /**< number of events ever written */
+    QAtomicInteger<quint64> base_; /**< the events before this one were cleared */
+    int tid_; /**< id used in the trace */
+    QString thread_name_; /**< name of the thread at registration */
+    bool retired_; /**< the thread that owned the buffer finished */
+};
+
+//! Retires the buffer of a thread when the thread finishes.
+class GrpTraceOwner {
+public:
+    GrpTraceOwner () : buffer_(NULL) {}
+    ~GrpTraceOwner ();
+    GrpTraceBuffer * buffer_; /**< the buffer of this thread */
+};
+
+QAtomicInt GroupTracer::enabled_ (0);
+
+static QMutex g_trace_mutex;
+static QList<GrpTraceBuffer*> g_trace_buffers;
+static QList<GrpTraceBuffer*> g_trace_retired;
+static int g_trace_capacity = 65536;
+static int g_trace_last_tid = 0;
+static QElapsedTimer g_trace_clock;
+static thread_local GrpTraceBuffer * t_trace_buffer = NULL;
+static thread_local GrpTraceOwner t_trace_owner;
+
+/* ------------------------------------------------------------------------- */
+GrpTraceOwner::~GrpTraceOwner ()
+{
+    if (buffer_ != NULL) {
+        QMutexLocker lock (&g_trace_mutex);
+        buffer_->retired_ = true;
+        g_trace_retired.append (buffer_);
+        buffer_ = NULL;
+    }
+    t_trace_buffer = NULL;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The buffer retired first is reused, so the events of the threads that
+ * finished recently are kept longer.
+ */
+static GrpTraceBuffer * traceBuffer ()
+{
+    if (t_trace_buffer == NULL) {
+        QMutexLocker lock (&g_trace_mutex);
+        int tid = ++g_trace_last_tid;
+        QThread * thread = QThread::currentThread ();
+        QString name = thread->objectName ();
+        if (name.isEmpty ()) {
+            QCoreApplication * app = QCoreApplication::instance ();
+            name = ((app != NULL) && (thread == app->thread ())) ?
+                        QString ("GUI") :
+                        QString ("Thread %1").arg (tid);
+        }
+
+        GrpTraceBuffer * buf;
+        if (g_trace_retired.isEmpty ()) {
+            buf = new GrpTraceBuffer (g_trace_capacity, tid, name);
+            g_trace_buffers.append (buf);
+        } else {
+            // nobody writes into a retired buffer and readers hold the mutex
+            buf = g_trace_retired.takeFirst ();
+            if (buf->events_.count () != g_trace_capacity)
+                buf->events_ = QVector<GrpTraceEvent> (g_trace_capacity);
+            buf->head_.storeRelease (0);
+            buf->base_.storeRelease (0);
+            buf->tid_ = tid;
+            buf->thread_name_ = name;
+            buf->retired_ = false;
+        }
+        t_trace_owner.buffer_ = buf;
+        t_trace_buffer = buf;
+    }
+    return t_trace_buffer;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+static void traceRecord (const char * name, char phase)
+{
+    GrpTraceBuffer * buf = traceBuffer ();
+    quint64 head = buf->head_.load ();
+    GrpTraceEvent & ev = buf->events_[static_cast<int>(head % buf->events_.count ())];
+    ev.name_ = name;
+    ev.ts_ns_ = g_trace_clock.nsecsElapsed ();
+    ev.phase_ = phase;
+    buf->head_.storeRelease (head + 1);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTracer::setEnabled (bool value)
+{
+    if (value) {
+        QMutexLocker lock (&g_trace_mutex);
+        if (!g_trace_clock.isValid ())
+            g_trace_clock.start ();
+    }
+    enabled_.store (value ? 1 : 0);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int GroupTracer::bufferSize ()
+{
+    QMutexLocker lock (&g_trace_mutex);
+    return g_trace_capacity;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTracer::setBufferSize (int value)
+{
+    QMutexLocker lock (&g_trace_mutex);
+    g_trace_capacity = qMax (16, value);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTracer::begin (const char * name)
+{
+    traceRecord (name, 'B');
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTracer::end (const char * name)
+{
+    traceRecord (name, 'E');
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The buffers are not released (the threads that own them may still
+ * be recording); the start of each ring is moved to its current end,
+ * so the owners are not disturbed.
+ */
+void GroupTracer::clear ()
+{
+    QMutexLocker lock (&g_trace_mutex);
+    foreach (GrpTraceBuffer * buf, g_trace_buffers) {
+        buf->base_.storeRelease (buf->head_.loadAcquire ());
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+static void appendJsonString (QByteArray & out, const QString & value)
+{
+    out.append ('"');
+    foreach (QChar c, value) {
+        if ((c == QLatin1Char ('"')) || (c == QLatin1Char ('\\'))) {
+            out.append ('\\');
+            out.append (c.toLatin1 ());
+        } else if (c.unicode () < 0x20) {
+            out.append (' ');
+        } else {
+            out.append (QString (c).toUtf8 ());
+        }
+    }
+    out.append ('"');
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QByteArray GroupTracer::toJson ()
+{
+    QByteArray result;
+    result.append ("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    QByteArray pid = QByteArray::number (QCoreApplication::applicationPid ());
+    bool b_first = true;
+
+    QMutexLocker lock (&g_trace_mutex);
+    foreach (GrpTraceBuffer * buf, g_trace_buffers) {
+        QByteArray tid = QByteArray::number (buf->tid_);
+
+        if (!b_first)
+            result.append (',');
+        b_first = false;
+        result.append ("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":");
+        result.append (pid);
+        result.append (",\"tid\":");
+        result.append (tid);
+        result.append (",\"args\":{\"name\":");
+        appendJsonString (result, buf->retired_ ?
+                              buf->thread_name_ + QLatin1String (" (finished)") :
+                              buf->thread_name_);
+        result.append ("}}");
+
+        // copy the ring, then drop what the owner overwrote meanwhile
+        int capacity = buf->events_.count ();
+        quint64 head = buf->head_.loadAcquire ();
+        quint64 first = head > static_cast<quint64>(capacity) ? head - capacity : 0;
+        first = qMax (first, buf->base_.loadAcquire ());
+        if (first > head)
+            first = head;
+        QVector<GrpTraceEvent> copy;
+        copy.reserve (static_cast<int>(head - first));
+        for (quint64 i = first; i < head; ++i) {
+            copy.append (buf->events_.at (static_cast<int>(i % capacity)));
+        }
+        quint64 head_after = buf->head_.loadAcquire ();
+        quint64 valid = head_after > static_cast<quint64>(capacity) ?
+                    head_after - capacity : 0;
+        int skip = valid > first ? static_cast<int>(valid - first) : 0;
+
+        for (int i = skip; i < copy.count (); ++i) {
+            const GrpTraceEvent & ev = copy.at (i);
+            result.append (",{\"name\":");
+            appendJsonString (result, QLatin1String (ev.name_));
+            result.append (",\"cat\":\"grouplistwidget\",\"ph\":\"");
+            result.append (ev.phase_);
+            result.append ("\",\"ts\":");
+            result.append (QByteArray::number (ev.ts_ns_ / 1000.0, 'f', 3));
+            result.append (",\"pid\":");
+            result.append (pid);
+            result.append (",\"tid\":");
+            result.append (tid);
+            result.append ('}');
+        }
+    }
+    result.append ("]}\n");
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool GroupTracer::dump (const QString & path)
+{
+    QFile file (path);
+    if (!file.open (QIODevice::WriteOnly | QIODevice::Truncate)) {
+        GROUPLISTWIDGET_LOG_WARNING(
+                    grpLogTrace,
+                    "Cannot write trace to %s",
+                    qPrintable (path));
+        return false;
+    }
+    QByteArray data = toJson ();
+    return file.write (data) == data.size ();
+}
+/* ========================================================================= */
@@ -0,0 +1,93 @@
+/**
+ * @file grouptracer.h
+ * @brief Declarations for GroupTracer class
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#ifndef GUARD_GROUPTRACER_H_INCLUDE
+#define GUARD_GROUPTRACER_H_INCLUDE
+
+#include <grouplistwidget/grouplistwidget-config.h>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QString>
+
+//! Records begin and end events for Chrome / Perfetto traces.
+class GROUPLISTWIDGET_EXPORT GroupTracer {
+
+public:
+
+    //! Is recording enabled?
+    static bool
+    isEnabled () {
+        return enabled_.load () != 0;
+    }
+
+    //! Start or stop recording.
+    static void
+    setEnabled (
+            bool value);
+
+    //! Number of events kept for each thread.
+    static int
+    bufferSize ();
+
+    //! Change the number of events kept for threads that start recording later.
+    static void
+    setBufferSize (
+            int value);
+
+    //! Record the beginning of a scope in the calling thread.
+    static void
+    begin (
+            const char * name);
+
+    //! Record the end of a scope in the calling thread.
+    static void
+    end (
+            const char * name);
+
+    //! Forget the events recorded so far (stop recording first for exact results).
+    static void
+    clear ();
+
+    //! The events in trace event format (stop recording first for exact results).
+    static QByteArray
+    toJson ();
+
+    //! Write the events in trace event format to a file.
+    static bool
+    dump (
+            const QString & path);
+
+private:
+
+    static QAtomicInt enabled_; /**< non-zero while recording */
+};
+
+//! Records a begin event on construction and an end event on destruction.
+class GroupTraceScope {
+public:
+    explicit GroupTraceScope (const char * name) :
+        name_(NULL)
+    {
+        if (GroupTracer::isEnabled ()) {
+            name_ = name;
+            GroupTracer::begin (name);
+        }
+    }
+    ~GroupTraceScope () {
+        if (name_ != NULL)
+            GroupTracer::end (name_);
+    }
+private:
+    const char * name_; /**< the name of the scope if begin was recorded */
+};
+
+//! Traces the enclosing scope; the name must be a string literal.
+#define GROUPLISTWIDGET_TRACE_SCOPE(__name__) \
+    GroupTraceScope grp_trace_scope_ (__name__)
+
+#endif // GUARD_GROUPTRACER_H_INCLUDE
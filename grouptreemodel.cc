@@ -0,0 +1,465 @@
+/**
+ * @file grouptreemodel.cc
+ * @brief Definitions for GroupTreeModel class.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#include "grouptreemodel.h"
+#include "groupmodel.h"
+#include "groupsubmodel.h"
+#include "grouplistwidget-private.h"
+
+/**
+ * @class GroupTreeModel
+ *
+ * The groups are the top level rows (in the order given by
+ * GroupModel::group()) and the items in each group are their children.
+ * Nothing is copied: the rows are mapped through the storage of
+ * GroupModel and GroupSubModel, so the model can be used with a plain
+ * QTreeView (possibly with uniformRowHeights) for very large datasets.
+ *
+ * The internal id of an index is 0 for groups and the row of the
+ * group plus one for items, so both index() and parent() take
+ * constant time.
+ *
+ * Insertions, removals, moves, data changes and layout changes in
+ * a group are forwarded as such. A reset of a group or a change in
+ * the direction of grouping is forwarded as a reset of the whole model.
+ *
+ * The instance does not own the GroupModel.
+ */
+
+/* ------------------------------------------------------------------------- */
+GroupTreeModel::GroupTreeModel (GroupModel * model, QObject * parent) :
+    QAbstractItemModel (parent),
+    m_(),
+    resetting_(false),
+    group_resetting_(false),
+    layout_from_(),
+    layout_rows_()
+{
+    GROUPLISTWIDGET_TRACE_ENTRY;
+    installModel (model);
+    GROUPLISTWIDGET_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupTreeModel::~GroupTreeModel ()
+{
+    GROUPLISTWIDGET_TRACE_ENTRY;
+    uninstallModel ();
+    GROUPLISTWIDGET_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTreeModel::setGroupModel (GroupModel * model)
+{
+    GROUPLISTWIDGET_TRACE_ENTRY;
+    if (m_ == model)
+        return;
+    beginResetModel ();
+    uninstallModel ();
+    installModel (model);
+    endResetModel ();
+    GROUPLISTWIDGET_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTreeModel::installModel (GroupModel * model)
+{
+    m_ = model;
+    if (model == NULL)
+        return;
+    connect (model, &GroupModel::modelAboutToBeReset,
+             this, &GroupTreeModel::underModelAboutToBeReset);
+    connect (model, &GroupModel::modelReset,
+             this, &GroupTreeModel::underModelReset);
+    connect (model, &GroupModel::groupingChanged,
+             this, &GroupTreeModel::underModelReset);
+    connectGroups ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTreeModel::uninstallModel ()
+{
+    if (m_.isNull ())
+        return;
+    disconnect (m_, &GroupModel::modelAboutToBeReset,
+                this, &GroupTreeModel::underModelAboutToBeReset);
+    disconnect (m_, &GroupModel::modelReset,
+                this, &GroupTreeModel::underModelReset);
+    disconnect (m_, &GroupModel::groupingChanged,
+                this, &GroupTreeModel::underModelReset);
+    disconnectGroups ();
+    m_ = NULL;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTreeModel::connectGroups ()
+{
+    int i_max = m_->groupCount ();
+    for (int i = 0; i < i_max; ++i) {
+        GroupSubModel * gsm = m_->group (i);
+        connect (gsm, &QAbstractItemModel::modelAboutToBeReset,
+                 this, &GroupTreeModel::groupAboutToBeReset);
+        connect (gsm, &QAbstractItemModel::modelReset,
+                 this, &GroupTreeModel::groupReset);
+        connect (gsm, &QAbstractItemModel::rowsAboutToBeInserted,
+                 this, &GroupTreeModel::groupRowsAboutToBeInserted);
+        connect (gsm, &QAbstractItemModel::rowsInserted,
+                 this, &GroupTreeModel::groupRowsInserted);
+        connect (gsm, &QAbstractItemModel::rowsAboutToBeRemoved,
+                 this, &GroupTreeModel::groupRowsAboutToBeRemoved);
+        connect (gsm, &QAbstractItemModel::rowsRemoved,
+                 this, &GroupTreeModel::groupRowsRemoved);
+        connect (gsm, &QAbstractItemModel::rowsAboutToBeMoved,
+                 this, &GroupTreeModel::groupRowsAboutToBeMoved);
+        connect (gsm, &QAbstractItemModel::rowsMoved,
+                 this, &GroupTreeModel::groupRowsMoved);
+        connect (gsm, &QAbstractItemModel::dataChanged,
+                 this, &GroupTreeModel::groupDataChanged);
+        connect (gsm, &QAbstractItemModel::layoutAboutToBeChanged,
+                 this, &GroupTreeModel::groupLayoutAboutToBeChanged);
+        connect (gsm, &QAbstractItemModel::layoutChanged,
+                 this, &GroupTreeModel::groupLayoutChanged);
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTreeModel::disconnectGroups ()
+{
+    int i_max = m_->groupCount ();
+    for (int i = 0; i < i_max; ++i) {
+        disconnect (m_->group (i), NULL, this, NULL);
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+GroupSubModel * GroupTreeModel::groupFor (const QModelIndex & index) const
+{
+    if (m_.isNull () || !index.isValid ())
+        return NULL;
+    int g = index.internalId () == 0 ?
+                index.row () : static_cast<int>(index.internalId ()) - 1;
+    return m_->group (g);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QModelIndex GroupTreeModel::groupIndex (
+        const GroupSubModel * gsm, int column) const
+{
+    if (gsm == NULL)
+        return QModelIndex ();
+    return createIndex (gsm->listIndex (), column, quintptr (0));
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int GroupTreeModel::mapToBase (const QModelIndex & index) const
+{
+    if (!index.isValid () || isGroup (index))
+        return -1;
+    GroupSubModel * gsm = groupFor (index);
+    if (gsm == NULL)
+        return -1;
+    return gsm->mapRowToBaseModel (index.row ());
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Uses GroupModel::groupForRow(), so the lookup takes constant time.
+ */
+QModelIndex GroupTreeModel::mapFromBase (int base_row, int column) const
+{
+    if (m_.isNull ())
+        return QModelIndex ();
+    int index_in_group = -1;
+    GroupSubModel * gsm = m_->groupForRow (base_row, &index_in_group);
+    if (gsm == NULL)
+        return QModelIndex ();
+    return createIndex (index_in_group, column,
+                        quintptr (gsm->listIndex () + 1));
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QModelIndex GroupTreeModel::index (
+        int row, int column, const QModelIndex & parent) const
+{
+    if (!hasIndex (row, column, parent))
+        return QModelIndex ();
+    if (!parent.isValid ())
+        return createIndex (row, column, quintptr (0));
+    return createIndex (row, column, quintptr (parent.row () + 1));
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QModelIndex GroupTreeModel::parent (const QModelIndex & child) const
+{
+    if (!child.isValid () || (child.internalId () == 0))
+        return QModelIndex ();
+    return createIndex (
+                static_cast<int>(child.internalId ()) - 1, 0, quintptr (0));
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int GroupTreeModel::rowCount (const QModelIndex & parent) const
+{
+    if (m_.isNull () || (m_->baseModel () == NULL))
+        return 0;
+    if (!parent.isValid ())
+        return m_->groupCount ();
+    if (parent.internalId () != 0)
+        return 0;
+    GroupSubModel * gsm = m_->group (parent.row ());
+    return gsm == NULL ? 0 : gsm->rowCount ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int GroupTreeModel::columnCount (const QModelIndex &) const
+{
+    if (m_.isNull () || (m_->baseModel () == NULL))
+        return 1;
+    return qMax (1, m_->baseModel ()->columnCount ());
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool GroupTreeModel::hasChildren (const QModelIndex & parent) const
+{
+    return rowCount (parent) > 0;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Groups present their label in the first column. Items present the
+ * data of base model; the pixmap and the labels (GroupModel::BaseColRole)
+ * in the first column are served by GroupSubModel.
+ */
+QVariant GroupTreeModel::data (const QModelIndex & index, int role) const
+{
+    GroupSubModel * gsm = groupFor (index);
+    if (gsm == NULL)
+        return QVariant ();
+
+    if (isGroup (index)) {
+        if ((index.column () == 0) &&
+                ((role == Qt::DisplayRole) || (role == Qt::EditRole)))
+            return gsm->label ();
+        return QVariant ();
+    }
+
+    if (index.column () == 0)
+        return gsm->data (gsm->index (index.row (), 0), role);
+    int r = gsm->mapRowToBaseModel (index.row ());
+    if (r == -1)
+        return QVariant ();
+    return m_->baseModel ()->index (r, index.column ()).data (role);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QVariant GroupTreeModel::headerData (
+        int section, Qt::Orientation orientation, int role) const
+{
+    if (m_.isNull () || (m_->baseModel () == NULL))
+        return QVariant ();
+    return m_->baseModel ()->headerData (section, orientation, role);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+Qt::ItemFlags GroupTreeModel::flags (const QModelIndex & index) const
+{
+    if (!index.isValid ())
+        return Qt::NoItemFlags;
+    if (isGroup (index))
+        return Qt::ItemIsEnabled;
+    int r = mapToBase (index);
+    if (r == -1)
+        return Qt::NoItemFlags;
+    return m_->baseModel ()->flags (
+                m_->baseModel ()->index (r, index.column ())) &
+            ~Qt::ItemIsEditable;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The groups are destroyed by the model, and the connections with them.
+ */
+void GroupTreeModel::underModelAboutToBeReset ()
+{
+    if (resetting_)
+        return;
+    resetting_ = true;
+    beginResetModel ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Also used when the direction of grouping changes, as all the
+ * indexes of items depend on the order of the groups.
+ */
+void GroupTreeModel::underModelReset ()
+{
+    if (!resetting_)
+        beginResetModel ();
+    resetting_ = false;
+    if (!m_.isNull ()) {
+        // groups that survived the reset are already connected
+        disconnectGroups ();
+        connectGroups ();
+    }
+    endResetModel ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTreeModel::groupAboutToBeReset ()
+{
+    if (resetting_ || group_resetting_)
+        return;
+    group_resetting_ = true;
+    beginResetModel ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTreeModel::groupReset ()
+{
+    if (!group_resetting_)
+        return;
+    group_resetting_ = false;
+    endResetModel ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTreeModel::groupRowsAboutToBeInserted (
+        const QModelIndex &, int first, int last)
+{
+    const GroupSubModel * gsm = qobject_cast<GroupSubModel *>(sender ());
+    beginInsertRows (groupIndex (gsm), first, last);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTreeModel::groupRowsInserted ()
+{
+    endInsertRows ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTreeModel::groupRowsAboutToBeRemoved (
+        const QModelIndex &, int first, int last)
+{
+    const GroupSubModel * gsm = qobject_cast<GroupSubModel *>(sender ());
+    beginRemoveRows (groupIndex (gsm), first, last);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTreeModel::groupRowsRemoved ()
+{
+    endRemoveRows ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTreeModel::groupRowsAboutToBeMoved (
+        const QModelIndex &, int source_first, int source_last,
+        const QModelIndex &, int destination_row)
+{
+    const GroupSubModel * gsm = qobject_cast<GroupSubModel *>(sender ());
+    QModelIndex g = groupIndex (gsm);
+    beginMoveRows (g, source_first, source_last, g, destination_row);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTreeModel::groupRowsMoved ()
+{
+    endMoveRows ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The groups only have one column so the change is extended to
+ * all the columns.
+ */
+void GroupTreeModel::groupDataChanged (
+        const QModelIndex & top_left, const QModelIndex & bottom_right,
+        const QVector<int> & roles)
+{
+    const GroupSubModel * gsm = qobject_cast<GroupSubModel *>(sender ());
+    if (gsm == NULL)
+        return;
+    quintptr id = quintptr (gsm->listIndex () + 1);
+    emit dataChanged (
+                createIndex (top_left.row (), 0, id),
+                createIndex (bottom_right.row (), columnCount () - 1, id),
+                roles);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The persistent indexes of the items in the group are remembered
+ * by their rows in base model.
+ */
+void GroupTreeModel::groupLayoutAboutToBeChanged ()
+{
+    const GroupSubModel * gsm = qobject_cast<GroupSubModel *>(sender ());
+    QModelIndex g = groupIndex (gsm);
+    emit layoutAboutToBeChanged (QList<QPersistentModelIndex> () << g);
+
+    layout_from_.clear ();
+    layout_rows_.clear ();
+    quintptr id = quintptr (g.row () + 1);
+    foreach (const QModelIndex & idx, persistentIndexList ()) {
+        if (idx.internalId () == id) {
+            layout_from_.append (idx);
+            layout_rows_.append (mapToBase (idx));
+        }
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void GroupTreeModel::groupLayoutChanged ()
+{
+    const GroupSubModel * gsm = qobject_cast<GroupSubModel *>(sender ());
+    QModelIndexList to;
+    to.reserve (layout_from_.count ());
+    int i_max = layout_from_.count ();
+    for (int i = 0; i < i_max; ++i) {
+        to.append (mapFromBase (
+                       layout_rows_.at (i), layout_from_.at (i).column ()));
+    }
+    changePersistentIndexList (layout_from_, to);
+    layout_from_.clear ();
+    layout_rows_.clear ();
+    emit layoutChanged (QList<QPersistentModelIndex> () << groupIndex (gsm));
+}
+/* ========================================================================= */
+
+void GroupTreeModel::anchorVtable () const {}
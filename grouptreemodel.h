@@ -0,0 +1,195 @@
+/**
+ * @file grouptreemodel.h
+ * @brief Declarations for GroupTreeModel class
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ */
+#ifndef GUARD_GROUPTREEMODEL_H_INCLUDE
+#define GUARD_GROUPTREEMODEL_H_INCLUDE
+
+#include <grouplistwidget/grouplistwidget-config.h>
+#include <QAbstractItemModel>
+#include <QPointer>
+#include <QList>
+#include <QVector>
+
+class GroupModel;
+class GroupSubModel;
+
+//! Presents a GroupModel as a two level tree to standard views.
+class GROUPLISTWIDGET_EXPORT GroupTreeModel : public QAbstractItemModel {
+    Q_OBJECT
+
+public:
+
+    //! Default constructor.
+    explicit GroupTreeModel (
+            GroupModel * model = NULL,
+            QObject * parent = NULL);
+
+    //! Destructor.
+    virtual ~GroupTreeModel ();
+
+    //! Change the model that is presented.
+    void
+    setGroupModel (
+            GroupModel * model);
+
+    //! The model that is presented.
+    GroupModel *
+    groupModel () const {
+        return m_;
+    }
+
+    //! Is this index a group (a top level row)?
+    bool
+    isGroup (
+            const QModelIndex & index) const {
+        return index.isValid () && (index.internalId () == 0);
+    }
+
+    //! The group for a top level row or for one of its children.
+    GroupSubModel *
+    groupFor (
+            const QModelIndex & index) const;
+
+    //! The index of the top level row for a group.
+    QModelIndex
+    groupIndex (
+            const GroupSubModel * gsm,
+            int column = 0) const;
+
+    //! The row in base model for an item (-1 for groups).
+    int
+    mapToBase (
+            const QModelIndex & index) const;
+
+    //! The index of an item given its row in base model.
+    QModelIndex
+    mapFromBase (
+            int base_row,
+            int column = 0) const;
+
+    virtual QModelIndex
+    index (
+            int row,
+            int column,
+            const QModelIndex & parent = QModelIndex()) const;
+
+    virtual QModelIndex
+    parent (
+            const QModelIndex & child) const;
+
+    virtual int
+    rowCount (
+            const QModelIndex & parent = QModelIndex()) const;
+
+    virtual int
+    columnCount (
+            const QModelIndex & parent = QModelIndex()) const;
+
+    virtual bool
+    hasChildren (
+            const QModelIndex & parent = QModelIndex()) const;
+
+    virtual QVariant
+    data (
+            const QModelIndex & index,
+            int role = Qt::DisplayRole) const;
+
+    virtual QVariant
+    headerData (
+            int section,
+            Qt::Orientation orientation,
+            int role = Qt::DisplayRole) const;
+
+    virtual Qt::ItemFlags
+    flags (
+            const QModelIndex & index) const;
+
+private slots:
+
+    void
+    underModelAboutToBeReset ();
+
+    void
+    underModelReset ();
+
+    void
+    groupAboutToBeReset ();
+
+    void
+    groupReset ();
+
+    void
+    groupRowsAboutToBeInserted (
+            const QModelIndex & parent,
+            int first,
+            int last);
+
+    void
+    groupRowsInserted ();
+
+    void
+    groupRowsAboutToBeRemoved (
+            const QModelIndex & parent,
+            int first,
+            int last);
+
+    void
+    groupRowsRemoved ();
+
+    void
+    groupRowsAboutToBeMoved (
+            const QModelIndex & source_parent,
+            int source_first,
+            int source_last,
+            const QModelIndex & destination_parent,
+            int destination_row);
+
+    void
+    groupRowsMoved ();
+
+    void
+    groupDataChanged (
+            const QModelIndex & top_left,
+            const QModelIndex & bottom_right,
+            const QVector<int> & roles);
+
+    void
+    groupLayoutAboutToBeChanged ();
+
+    void
+    groupLayoutChanged ();
+
+private:
+
+    //! Connect to the signals of all groups.
+    void
+    connectGroups ();
+
+    //! Disconnect from the signals of all groups.
+    void
+    disconnectGroups ();
+
+    //! Connect to the signals of the model.
+    void
+    installModel (
+            GroupModel * model);
+
+    //! Disconnect from the signals of the model.
+    void
+    uninstallModel ();
+
+    QPointer<GroupModel> m_; /**< the model that is presented */
+    bool resetting_; /**< a reset of the whole model is in progress */
+    bool group_resetting_; /**< a group is being reset */
+    QModelIndexList layout_from_; /**< persistent children of a group being rearranged */
+    QList<int> layout_rows_; /**< the rows in base model for layout_from_ */
+
+public: virtual void anchorVtable() const;
+}; // class GroupTreeModel
+
+#endif // GUARD_GROUPTREEMODEL_H_INCLUDE
@@ -0,0 +1,567 @@
+/**
+ * @file stress.cc
+ * @brief Differential stress harness for GroupModel.
+ * @author Nicu Tofan <nicu.tofan@gmail.com>
+ * @copyright Copyright 2015 piles contributors. All rights reserved.
+ * This file is released under the
+ * [MIT License](http://opensource.org/licenses/mit-license.html)
+ *
+ * Applies random sequences of changes to a base model and of grouping,
+ * sorting and label operations to a GroupModel. After each step the
+ * groups, their keys and labels, the mapping(), mapRowToBaseModel(),
+ * groupForRow() and the labels of the items are compared with a
+ * GroupModel that is freshly built from the same base model and
+ * settings. A QAbstractItemModelTester watches every GroupSubModel.
+ *
+ * Changes that GroupModel does not yet follow on its own (see
+ * incrementalKinds()) are compared as they are, then followed by a call
+ * to regroup() and compared again. A difference before regroup() is an
+ * expected failure; a kind that never differs across the whole run is an
+ * unexpected pass and means that GroupModel learned to follow it, so the
+ * kind should be moved to incrementalKinds().
+ *
+ * The exit code is 0 if no difference was found where none was expected
+ * and every kind that is expected to differ did so at least once.
+ */
+#include <grouplistwidget/groupmodel.h>
+#include <grouplistwidget/groupsubmodel.h>
+
+#include <QAbstractItemModelTester>
+#include <QAbstractTableModel>
+#include <QCommandLineParser>
+#include <QGuiApplication>
+#include <QStringList>
+
+#include <cstdio>
+#include <random>
+
+/* ------------------------------------------------------------------------- */
+static int pick (std::mt19937 & gen, int lo, int hi)
+{
+    return std::uniform_int_distribution<int> (lo, hi) (gen);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+//! A table with keys for grouping and sorting (with many duplicates).
+class StressModel : public QAbstractTableModel {
+public:
+
+    enum Column {
+        ColIntKey = 0, /**< small integers, used for grouping */
+        ColStringKey, /**< a few words, used for grouping */
+        ColIntSort, /**< integers with ties, used for sorting */
+        ColDoubleSort, /**< doubles with ties, used for sorting */
+        ColLabel, /**< free text */
+        ColCount
+    };
+
+    explicit StressModel (std::mt19937 & gen) : gen_(gen), rows_() {}
+
+    int rowCount (const QModelIndex & parent = QModelIndex()) const {
+        return parent.isValid () ? 0 : rows_.count ();
+    }
+
+    int columnCount (const QModelIndex & parent = QModelIndex()) const {
+        return parent.isValid () ? 0 : ColCount;
+    }
+
+    QVariant data (const QModelIndex & index, int role = Qt::DisplayRole) const {
+        if (!index.isValid () || (index.row () >= rows_.count ()))
+            return QVariant ();
+        if ((role != Qt::DisplayRole) && (role != Qt::EditRole))
+            return QVariant ();
+        return rows_.at (index.row ()).at (index.column ());
+    }
+
+    QVariant headerData (int section, Qt::Orientation orientation,
+                         int role = Qt::DisplayRole) const {
+        if ((orientation != Qt::Horizontal) || (role != Qt::DisplayRole))
+            return QVariant ();
+        static const char * names[ColCount] = {
+            "int key", "string key", "int sort", "double sort", "label" };
+        return (section >= 0) && (section < ColCount) ?
+                    QVariant (QString (names[section])) : QVariant ();
+    }
+
+    QVariant randomValue (int column) {
+        static const char * words[] = {
+            "alpha", "beta", "gamma", "delta", "epsilon", "zeta" };
+        switch (column) {
+        case ColIntKey: return pick (gen_, 0, 7);
+        case ColStringKey: return QString (words[pick (gen_, 0, 5)]);
+        case ColIntSort: return pick (gen_, 0, 20);
+        case ColDoubleSort: return pick (gen_, 0, 10) + 0.5;
+        default: return QString ("item %1").arg (pick (gen_, 0, 999));
+        }
+    }
+
+    QVector<QVariant> randomRow () {
+        QVector<QVariant> result (ColCount);
+        for (int c = 0; c < ColCount; ++c) {
+            result[c] = randomValue (c);
+        }
+        return result;
+    }
+
+    void resetRows (int count) {
+        beginResetModel ();
+        rows_.clear ();
+        for (int i = 0; i < count; ++i) {
+            rows_.append (randomRow ());
+        }
+        endResetModel ();
+    }
+
+    //! Change a range of rows in one column with a single signal.
+    void changeRange (int first, int last, int column) {
+        for (int i = first; i <= last; ++i) {
+            rows_[i][column] = randomValue (column);
+        }
+        emit dataChanged (index (first, column), index (last, column));
+    }
+
+    void insertRandomRows (int first, int count) {
+        beginInsertRows (QModelIndex (), first, first + count - 1);
+        for (int i = 0; i < count; ++i) {
+            rows_.insert (first, randomRow ());
+        }
+        endInsertRows ();
+    }
+
+    void removeSomeRows (int first, int count) {
+        beginRemoveRows (QModelIndex (), first, first + count - 1);
+        rows_.remove (first, count);
+        endRemoveRows ();
+    }
+
+    void moveOneRow (int from, int to) {
+        if (!beginMoveRows (QModelIndex (), from, from, QModelIndex (), to))
+            return;
+        QVector<QVariant> row = rows_.at (from);
+        rows_.remove (from);
+        rows_.insert (to > from ? to - 1 : to, row);
+        endMoveRows ();
+    }
+
+private:
+    std::mt19937 & gen_;
+    QVector<QVector<QVariant> > rows_;
+};
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+//! The kinds of steps.
+enum StepKind {
+    StepLabelChange = 0,
+    StepKeyChange,
+    StepSortKeyChange,
+    StepDataStorm,
+    StepInsert,
+    StepRemove,
+    StepMove,
+    StepReset,
+    StepGroupingColumn,
+    StepGroupingDirection,
+    StepSortingColumn,
+    StepSortingDirection,
+    StepLabels,
+    StepRegroup,
+    StepCount
+};
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+static const char * stepName (int kind)
+{
+    static const char * names[StepCount] = {
+        "label change", "group key change", "sort key change", "data storm",
+        "insert rows", "remove rows", "move row", "reset",
+        "grouping column", "grouping direction", "sorting column",
+        "sorting direction", "labels", "regroup" };
+    return names[kind];
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+//! Changes that GroupModel is expected to follow without a regroup().
+static bool incrementalKinds (int kind)
+{
+    switch (kind) {
+    case StepLabelChange:
+    case StepGroupingColumn:
+    case StepGroupingDirection:
+    case StepSortingColumn:
+    case StepSortingDirection:
+    case StepLabels:
+    case StepRegroup:
+        return true;
+    default:
+        return false;
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+static int model_test_failures = 0;
+
+//! Counts the complaints of QAbstractItemModelTester.
+static void messageHandler (
+        QtMsgType type, const QMessageLogContext & context, const QString & msg)
+{
+    if ((type != QtDebugMsg) && (type != QtInfoMsg) &&
+            (context.category != NULL) &&
+            (qstrcmp (context.category, "qt.modeltest") == 0)) {
+        ++model_test_failures;
+    }
+    if (type != QtDebugMsg)
+        fprintf (stderr, "%s\n", qPrintable (msg));
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+//! Make sure every group is watched by a tester.
+static void attachTesters (GroupModel * m)
+{
+    for (int g = 0; g < m->groupCount (); ++g) {
+        GroupSubModel * subm = m->group (g);
+        if (subm->findChild<QAbstractItemModelTester*> () == NULL) {
+            new QAbstractItemModelTester (
+                        subm,
+                        QAbstractItemModelTester::FailureReportingMode::Warning,
+                        subm);
+        }
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+//! Compare the model with a fresh one; returns an empty string if they match.
+static QString compareWithFresh (GroupModel * m)
+{
+    QAbstractItemModel * base = m->baseModel ();
+    GroupModel fresh;
+    fresh.setGroupingRole (m->groupingRole ());
+    fresh.setGroupLabelRole (m->groupLabelRole ());
+    fresh.setSortingRole (m->sortingRole ());
+    for (int i = 0; i < m->labelCount (); ++i) {
+        if (i < fresh.labelCount ())
+            fresh.setLabel (m->label (i), i);
+        else
+            fresh.addLabel (m->label (i));
+    }
+    fresh.setBaseModel (base, m->groupingColumn (), m->sortingColumn (),
+                        m->groupingDirection (), m->sortingDirection ());
+
+    QString result;
+    for (;;) {
+        if (m->groupCount () != fresh.groupCount ()) {
+            result = QString ("%1 groups instead of %2")
+                    .arg (m->groupCount ()).arg (fresh.groupCount ());
+            break;
+        }
+        for (int g = 0; g < m->groupCount () && result.isEmpty (); ++g) {
+            GroupSubModel * a = m->group (g);
+            GroupSubModel * b = fresh.group (g);
+            if (a->groupKey () != b->groupKey ()) {
+                result = QString ("group %1: key %2 instead of %3").arg (g)
+                        .arg (a->groupKey ().toString ())
+                        .arg (b->groupKey ().toString ());
+            } else if (a->label () != b->label ()) {
+                result = QString ("group %1: label %2 instead of %3").arg (g)
+                        .arg (a->label ()).arg (b->label ());
+            } else if (a->listIndex () != b->listIndex ()) {
+                result = QString ("group %1: list index %2 instead of %3")
+                        .arg (g).arg (a->listIndex ()).arg (b->listIndex ());
+            } else if (a->mapping () != b->mapping ()) {
+                result = QString ("group %1: mapping differs").arg (g);
+            } else if (a->rowCount () != b->rowCount ()) {
+                result = QString ("group %1: %2 rows instead of %3").arg (g)
+                        .arg (a->rowCount ()).arg (b->rowCount ());
+            }
+            for (int r = 0; r < a->rowCount () && result.isEmpty (); ++r) {
+                if (a->mapRowToBaseModel (r) != b->mapRowToBaseModel (r)) {
+                    result = QString ("group %1 row %2: base row %3 "
+                                      "instead of %4").arg (g).arg (r)
+                            .arg (a->mapRowToBaseModel (r))
+                            .arg (b->mapRowToBaseModel (r));
+                    break;
+                }
+                for (int l = 0; l < m->labelCount (); ++l) {
+                    QModelIndex ia = a->index (r, 0);
+                    QModelIndex ib = b->index (r, 0);
+                    int role = GroupModel::BaseColRole + l;
+                    if (ia.data (role) != ib.data (role)) {
+                        result = QString ("group %1 row %2: label %3 is "
+                                          "\"%4\" instead of \"%5\"")
+                                .arg (g).arg (r).arg (l)
+                                .arg (ia.data (role).toString ())
+                                .arg (ib.data (role).toString ());
+                        break;
+                    }
+                }
+            }
+        }
+        if (!result.isEmpty ())
+            break;
+
+        int row_max = base == NULL ? 0 : base->rowCount ();
+        for (int r = 0; r < row_max; ++r) {
+            int ia = -1, ib = -1;
+            GroupSubModel * ga = m->groupForRow (r, &ia);
+            GroupSubModel * gb = fresh.groupForRow (r, &ib);
+            int la = ga == NULL ? -1 : ga->listIndex ();
+            int lb = gb == NULL ? -1 : gb->listIndex ();
+            if ((la != lb) || (ia != ib)) {
+                result = QString ("groupForRow(%1): group %2 index %3 "
+                                  "instead of group %4 index %5")
+                        .arg (r).arg (la).arg (ia).arg (lb).arg (ib);
+                break;
+            }
+            if ((ga != NULL) && (ga->mapRowToBaseModel (ia) != r)) {
+                result = QString ("groupForRow(%1) points to base row %2")
+                        .arg (r).arg (ga->mapRowToBaseModel (ia));
+                break;
+            }
+        }
+        break;
+    }
+
+    fresh.takeBaseModel ();
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+//! Apply one random step; returns a description of it.
+static QString randomStep (
+        std::mt19937 & gen, GroupModel * m, StressModel * base, int max_rows,
+        int * p_kind)
+{
+    static const int group_cols[] = {
+        -1, StressModel::ColIntKey, StressModel::ColStringKey };
+    static const int sort_cols[] = {
+        -1, StressModel::ColIntSort, StressModel::ColDoubleSort,
+        StressModel::ColStringKey };
+
+    int rows = base->rowCount ();
+    int kind = pick (gen, 0, StepCount - 1);
+    if ((rows == 0) && (kind <= StepMove))
+        kind = StepInsert;
+    if ((rows >= max_rows) && (kind == StepInsert))
+        kind = StepRemove;
+
+    *p_kind = kind;
+    QString desc = stepName (kind);
+    switch (kind) {
+    case StepLabelChange: {
+        int r = pick (gen, 0, rows - 1);
+        base->changeRange (r, r, StressModel::ColLabel);
+        desc += QString (" row %1").arg (r);
+        break; }
+    case StepKeyChange: {
+        int r = pick (gen, 0, rows - 1);
+        int c = pick (gen, 0, 1) == 0 ?
+                    StressModel::ColIntKey : StressModel::ColStringKey;
+        base->changeRange (r, r, c);
+        desc += QString (" row %1 column %2").arg (r).arg (c);
+        break; }
+    case StepSortKeyChange: {
+        int r = pick (gen, 0, rows - 1);
+        int c = pick (gen, 0, 1) == 0 ?
+                    StressModel::ColIntSort : StressModel::ColDoubleSort;
+        base->changeRange (r, r, c);
+        desc += QString (" row %1 column %2").arg (r).arg (c);
+        break; }
+    case StepDataStorm: {
+        int first = pick (gen, 0, rows - 1);
+        int last = pick (gen, first, qMin (rows - 1, first + 50));
+        int c = pick (gen, 0, StressModel::ColCount - 1);
+        base->changeRange (first, last, c);
+        desc += QString (" rows %1-%2 column %3").arg (first).arg (last).arg (c);
+        break; }
+    case StepInsert: {
+        int first = pick (gen, 0, rows);
+        int count = pick (gen, 1, 10);
+        base->insertRandomRows (first, count);
+        desc += QString (" %1 at %2").arg (count).arg (first);
+        break; }
+    case StepRemove: {
+        int first = pick (gen, 0, rows - 1);
+        int count = pick (gen, 1, qMin (10, rows - first));
+        base->removeSomeRows (first, count);
+        desc += QString (" %1 at %2").arg (count).arg (first);
+        break; }
+    case StepMove: {
+        int from = pick (gen, 0, rows - 1);
+        int to = pick (gen, 0, rows);
+        base->moveOneRow (from, to);
+        desc += QString (" %1 to %2").arg (from).arg (to);
+        break; }
+    case StepReset: {
+        int count = pick (gen, 0, max_rows);
+        base->resetRows (count);
+        desc += QString (" with %1 rows").arg (count);
+        break; }
+    case StepGroupingColumn: {
+        int c = group_cols[pick (gen, 0, 2)];
+        m->setGroupingColumn (c);
+        desc += QString (" %1").arg (c);
+        break; }
+    case StepGroupingDirection: {
+        Qt::SortOrder o = Qt::SortOrder (pick (gen, 0, 1));
+        m->setGroupingDirection (o);
+        desc += QString (" %1").arg (o);
+        break; }
+    case StepSortingColumn: {
+        int c = sort_cols[pick (gen, 0, 3)];
+        m->setSortingColumn (c);
+        desc += QString (" %1").arg (c);
+        break; }
+    case StepSortingDirection: {
+        Qt::SortOrder o = Qt::SortOrder (pick (gen, 0, 1));
+        m->setSortingDirection (o);
+        desc += QString (" %1").arg (o);
+        break; }
+    case StepLabels: {
+        int c = pick (gen, 0, StressModel::ColCount - 1);
+        int idx = pick (gen, 0, qMin (m->labelCount (), 3));
+        if (idx == m->labelCount ())
+            m->addLabel (c);
+        else
+            m->setLabel (c, Qt::DisplayRole, idx);
+        desc += QString (" %1 to column %2").arg (idx).arg (c);
+        break; }
+    case StepRegroup: {
+        m->regroup ();
+        break; }
+    }
+    return desc;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+//! Run one sequence; returns false at first unexpected difference.
+static bool runSequence (
+        quint32 seed, int steps, int max_rows, bool verbose,
+        int * seen, int * differed)
+{
+    std::mt19937 gen (seed);
+    StressModel * base = new StressModel (gen);
+    base->resetRows (pick (gen, 0, max_rows));
+
+    GroupModel m;
+    m.setBaseModel (base, StressModel::ColIntKey, StressModel::ColIntSort);
+    attachTesters (&m);
+
+    QString diff = compareWithFresh (&m);
+    for (int s = 0; s < steps && diff.isEmpty (); ++s) {
+        int kind = StepRegroup;
+        QString desc = randomStep (gen, &m, base, max_rows, &kind);
+        if (verbose)
+            fprintf (stdout, "seed %u step %d: %s\n", seed, s, qPrintable (desc));
+        attachTesters (&m);
+        diff = compareWithFresh (&m);
+        if (!incrementalKinds (kind)) {
+            ++seen[kind];
+            if (!diff.isEmpty ()) {
+                ++differed[kind];
+                if (verbose) {
+                    fprintf (stdout, "    expected difference: %s\n",
+                             qPrintable (diff));
+                }
+            }
+            m.regroup ();
+            attachTesters (&m);
+            diff = compareWithFresh (&m);
+            desc += QLatin1String (" and regroup()");
+        }
+        if (!diff.isEmpty ()) {
+            fprintf (stderr, "seed %u step %d (%s): %s\n",
+                     seed, s, qPrintable (desc), qPrintable (diff));
+        } else if (model_test_failures > 0) {
+            fprintf (stderr, "seed %u step %d (%s): the model tester "
+                             "reported %d problems\n",
+                     seed, s, qPrintable (desc), model_test_failures);
+            diff = QLatin1String ("model tester");
+        }
+    }
+    return diff.isEmpty ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int main (int argc, char *argv[])
+{
+    if (qgetenv ("QT_QPA_PLATFORM").isEmpty ())
+        qputenv ("QT_QPA_PLATFORM", "offscreen");
+
+    QGuiApplication app (argc, argv);
+    QGuiApplication::setApplicationName ("grouplistwidget-stress");
+    qInstallMessageHandler (messageHandler);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription (
+                "Compares GroupModel after random changes with a fresh model.");
+    parser.addHelpOption ();
+    QCommandLineOption opt_fast ("fast",
+                "Few short sequences with fixed seeds (for every build).");
+    QCommandLineOption opt_seed ("seed",
+                "Seed of the first sequence.", "value", "1");
+    QCommandLineOption opt_sequences ("sequences",
+                "Number of sequences.", "count", "100");
+    QCommandLineOption opt_steps ("steps",
+                "Steps in each sequence.", "count", "500");
+    QCommandLineOption opt_rows ("rows",
+                "Maximum number of rows in base model.", "count", "300");
+    QCommandLineOption opt_verbose ("verbose", "Print every step.");
+    parser.addOption (opt_fast);
+    parser.addOption (opt_seed);
+    parser.addOption (opt_sequences);
+    parser.addOption (opt_steps);
+    parser.addOption (opt_rows);
+    parser.addOption (opt_verbose);
+    parser.process (app);
+
+    quint32 seed = parser.value (opt_seed).toUInt ();
+    int sequences = qMax (1, parser.value (opt_sequences).toInt ());
+    int steps = qMax (1, parser.value (opt_steps).toInt ());
+    int max_rows = qMax (1, parser.value (opt_rows).toInt ());
+    if (parser.isSet (opt_fast)) {
+        seed = 1;
+        sequences = 5;
+        steps = 100;
+        max_rows = 60;
+    }
+    bool verbose = parser.isSet (opt_verbose);
+
+    int failed = 0;
+    int seen[StepCount] = { 0 };
+    int differed[StepCount] = { 0 };
+    for (int i = 0; i < sequences; ++i) {
+        if (!runSequence (seed + i, steps, max_rows, verbose, seen, differed))
+            ++failed;
+        model_test_failures = 0;
+    }
+
+    int unexpected = 0;
+    for (int k = 0; k < StepCount; ++k) {
+        if (seen[k] == 0)
+            continue;
+        if (differed[k] > 0) {
+            fprintf (stdout, "%s: %d of %d steps differed before regroup() "
+                             "(expected)\n",
+                     stepName (k), differed[k], seen[k]);
+        } else {
+            fprintf (stderr, "%s: none of %d steps differed before "
+                             "regroup() (unexpected pass; move it to "
+                             "incrementalKinds())\n",
+                     stepName (k), seen[k]);
+            ++unexpected;
+        }
+    }
+    fprintf (stdout, "%d of %d sequences failed, %d unexpected passes\n",
+             failed, sequences, unexpected);
+    return (failed == 0) && (unexpected == 0) ? 0 : 1;
+}
+/* ========================================================================= */